@@ -0,0 +1,281 @@
+/*
+This is free and unencumbered software released into the public domain.
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+For more information, please refer to <http://unlicense.org/>
+*/
+
+#include "format_binary.hpp"
+
+namespace fmt
+{
+bool binary_log_reader::read_arguments()
+{
+	uint64_t count;
+	if (!detail::read_varint(position, end, count) || count > uint64_t(end - position)) return false;
+	arguments.resize(size_t(count));
+	for (detail::binary_value & argument : arguments)
+	{
+		if (position == end) return false;
+		argument.type = static_cast<detail::binary_argument_type>(*position++);
+		switch (argument.type)
+		{
+		case detail::binary_signed:
+		{
+			uint64_t zigzag;
+			if (!detail::read_varint(position, end, zigzag)) return false;
+			argument.signed_value = int64_t((zigzag >> 1) ^ (0 - (zigzag & 1)));
+			break;
+		}
+		case detail::binary_unsigned:
+			if (!detail::read_varint(position, end, argument.unsigned_value)) return false;
+			break;
+		case detail::binary_char:
+			if (position == end) return false;
+			argument.char_value = *position++;
+			break;
+		case detail::binary_float:
+			if (end - position < ptrdiff_t(sizeof(float))) return false;
+			std::memcpy(&argument.float_value, position, sizeof(float));
+			position += sizeof(float);
+			break;
+		case detail::binary_double:
+			if (end - position < ptrdiff_t(sizeof(double))) return false;
+			std::memcpy(&argument.double_value, position, sizeof(double));
+			position += sizeof(double);
+			break;
+		case detail::binary_string:
+		{
+			uint64_t size;
+			if (!detail::read_varint(position, end, size) || size > uint64_t(end - position)) return false;
+			argument.string = position;
+			argument.string_size = size_t(size);
+			position += size;
+			break;
+		}
+		default:
+			return false;
+		}
+	}
+	return true;
+}
+}
+
+#ifndef DISABLE_GTEST
+#include <gtest/gtest.h>
+#include "stack_format.hpp"
+#include <limits>
+#include <random>
+namespace
+{
+typedef std::back_insert_iterator<std::string> string_it;
+std::string RenderAll(const std::string & binary)
+{
+	std::string text;
+	auto it = fmt::make_format_it(std::back_inserter(text));
+	fmt::binary_log_reader reader(binary.data(), binary.data() + binary.size());
+	while (reader.render_next(it) == fmt::binary_log_reader::ok)
+	{
+	}
+	return text;
+}
+struct custom
+{
+	int value;
+};
+template<typename C, typename It>
+fmt::format_it<C, It> format(fmt::format_it<C, It> it, const custom & value)
+{
+	return it.printpacked('#', value.value);
+}
+TEST(format_binary, matches_stack_format)
+{
+	std::string binary;
+	std::string expected;
+	{
+		fmt::binary_log<string_it> log(fmt::make_format_it(std::back_inserter(binary)));
+		const char * pointer = "pointer";
+		std::mt19937_64 random(11);
+		for (int i = 0; i < 1000; ++i)
+		{
+			uint64_t bits = random();
+			double d;
+			std::memcpy(&d, &bits, sizeof(d));
+			float f = float(int32_t(bits >> 32)) / float(uint32_t(bits) | 1);
+			int64_t big = int64_t(bits);
+			short small = short(bits);
+			log.format("%0 %1 %2 %3|%4|%5\n", d, f, big, small, unsigned(bits >> 40), i % 2 == 0);
+			expected += fmt::stack_format<256>("%0 %1 %2 %3|%4|%5\n", d, f, big, small, unsigned(bits >> 40), i % 2 == 0).c_str();
+		}
+		std::string long_string(1000, 'x');
+		log.format("%1%0%%%2 %3 %4\n", 'c', std::string("string"), pointer, long_string, custom{ 5 });
+		expected += fmt::stack_format<2048>("%1%0%%%2 %3 %4\n", 'c', std::string("string"), pointer, long_string, custom{ 5 }).c_str();
+		log.format("%0 %1\n", std::numeric_limits<long long>::min(), std::numeric_limits<unsigned long long>::max());
+		expected += fmt::stack_format<256>("%0 %1\n", std::numeric_limits<long long>::min(), std::numeric_limits<unsigned long long>::max()).c_str();
+		log.format("no arguments\n");
+		expected += "no arguments\n";
+	}
+	ASSERT_EQ(expected, RenderAll(binary));
+}
+TEST(format_binary, smaller_than_text)
+{
+	std::string binary;
+	std::string expected;
+	{
+		fmt::binary_log<string_it> log(fmt::make_format_it(std::back_inserter(binary)));
+		for (int i = 0; i < 1000; ++i)
+		{
+			log.format("request %0 user %1 status %2 took %3us and sent %4 bytes\n", 100000 + i, i % 37, 200, i * 7 % 5000, i * 1234);
+			expected += fmt::stack_format<256>("request %0 user %1 status %2 took %3us and sent %4 bytes\n", 100000 + i, i % 37, 200, i * 7 % 5000, i * 1234).c_str();
+		}
+	}
+	ASSERT_EQ(expected, RenderAll(binary));
+	ASSERT_LT(binary.size() * 3, expected.size());
+}
+TEST(format_binary, truncated)
+{
+	std::string binary;
+	fmt::binary_log<string_it> log(fmt::make_format_it(std::back_inserter(binary)));
+	log.format("%0 %1\n", 1, "first");
+	size_t complete = binary.size();
+	log.format("%0 %1\n", 2, "second");
+	for (size_t size = complete; size < binary.size(); ++size)
+	{
+		std::string text;
+		auto it = fmt::make_format_it(std::back_inserter(text));
+		fmt::binary_log_reader reader(binary.data(), binary.data() + size);
+		ASSERT_EQ(fmt::binary_log_reader::ok, reader.render_next(it));
+		ASSERT_EQ(size == complete ? fmt::binary_log_reader::end_of_input : fmt::binary_log_reader::truncated, reader.render_next(it));
+		ASSERT_EQ("1 first\n", text);
+	}
+	std::string text;
+	auto it = fmt::make_format_it(std::back_inserter(text));
+	const char not_a_log[] = "text";
+	ASSERT_EQ(fmt::binary_log_reader::bad_header, fmt::binary_log_reader(not_a_log, not_a_log + 4).render_next(it));
+}
+TEST(format_binary, corrupt)
+{
+	// a define with an id that is far too large
+	const char huge_id[] = "fmtblog1\x01\xff\xff\xff\xff\xff\xff\xff\xff\x3f\x00";
+	std::string text;
+	auto it = fmt::make_format_it(std::back_inserter(text));
+	fmt::binary_log_reader reader(huge_id, huge_id + sizeof(huge_id) - 1);
+	ASSERT_EQ(fmt::binary_log_reader::truncated, reader.render_next(it));
+	ASSERT_EQ(huge_id + 8, reader.remaining());
+
+	std::string binary;
+	fmt::binary_log<string_it> log(fmt::make_format_it(std::back_inserter(binary)));
+	for (int i = 0; i < 10; ++i)
+	{
+		log.format("%0 %1 %2\n", i, "text", i * 0.5);
+		log.format("%0%%\n", 'c');
+	}
+	// overwrite single bytes. the reader may stop early or throw format_error,
+	// but it must not read out of bounds or throw anything else
+	std::mt19937 random(3);
+	for (size_t i = sizeof(fmt::detail::binary_log_magic); i < binary.size(); ++i)
+	{
+		for (int j = 0; j < 8; ++j)
+		{
+			std::string corrupt = binary;
+			corrupt[i] = char(j == 0 ? 0xff : random());
+			text.clear();
+			fmt::binary_log_reader reader(corrupt.data(), corrupt.data() + corrupt.size());
+			for (;;)
+			{
+				fmt::binary_log_reader::status status;
+				try
+				{
+					status = reader.render_next(it);
+				}
+				catch (const fmt::format_error &)
+				{
+					continue;
+				}
+				if (status != fmt::binary_log_reader::ok) break;
+			}
+		}
+	}
+}
+TEST(format_binary, format_errors)
+{
+	// mistakes in the format string throw at the call site, before anything
+	// is written
+	std::string binary;
+	fmt::binary_log<string_it> log(fmt::make_format_it(std::back_inserter(binary)));
+	size_t header_size = binary.size();
+	ASSERT_THROW(log.format("%0 %1\n", 1), fmt::format_error);
+	ASSERT_THROW(log.format("%0\n", 1, 2), fmt::format_error);
+	ASSERT_THROW(log.format("%18446744073709551617\n", 1, 2), fmt::format_error);
+	ASSERT_EQ(header_size, binary.size());
+	log.format("fine\n");
+	ASSERT_EQ("fine\n", RenderAll(binary));
+}
+fmt::format_error::Reason render_error(fmt::binary_log_reader & reader)
+{
+	std::string text;
+	auto it = fmt::make_format_it(std::back_inserter(text));
+	try
+	{
+		reader.render_next(it);
+	}
+	catch (const fmt::format_error & error)
+	{
+		return error.reason();
+	}
+	ADD_FAILURE() << "rendered \"" << text << "\" without an error";
+	return fmt::format_error::UnusedArgument;
+}
+TEST(format_binary, format_errors_in_input)
+{
+	// a log that binary_log wouldn't write, for example from another version
+	std::string binary(fmt::detail::binary_log_magic, sizeof(fmt::detail::binary_log_magic));
+	auto record = [&binary](char id, const std::string & format, int num_arguments)
+	{
+		binary += char(fmt::detail::binary_log_define);
+		binary += id;
+		binary += char(format.size());
+		binary += format;
+		binary += char(fmt::detail::binary_log_record);
+		binary += id;
+		binary += char(num_arguments);
+		for (int i = 0; i < num_arguments; ++i)
+		{
+			binary += char(fmt::detail::binary_unsigned);
+			binary += char(i);
+		}
+	};
+	record(0, "%0 %1\n", 1);
+	record(1, "%0\n", 2);
+	// wraps around to 1 in 64 bits
+	record(2, "%18446744073709551617\n", 2);
+	record(3, "%0 %", 1);
+	record(4, "fine\n", 0);
+	fmt::binary_log_reader reader(binary.data(), binary.data() + binary.size());
+	ASSERT_EQ(fmt::format_error::FormatIndexOutOfRange, render_error(reader));
+	ASSERT_EQ(fmt::format_error::UnusedArgument, render_error(reader));
+	ASSERT_EQ(fmt::format_error::FormatIndexOutOfRange, render_error(reader));
+	ASSERT_EQ(fmt::format_error::OpenPercentAtEndOfInput, render_error(reader));
+	std::string text;
+	auto it = fmt::make_format_it(std::back_inserter(text));
+	ASSERT_EQ(fmt::binary_log_reader::ok, reader.render_next(it));
+	ASSERT_EQ("fine\n", text);
+}
+}
+#endif
@@ -0,0 +1,442 @@
+/*
+This is free and unencumbered software released into the public domain.
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+For more information, please refer to <http://unlicense.org/>
+*/
+
+#pragma once
+
+#include "format_cache.hpp"
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// writes log records in a compact binary form instead of formatting them:
+// fmt::binary_log<fd_sink> log(fmt::make_format_it(writer.sink()));
+// log.format("%0 took %1ms\n", name, milliseconds);
+// the first time a format string is used it gets written once together with
+// an id. after that a record is the id followed by the raw arguments:
+// integers as varints, floats and doubles as their IEEE bytes and strings
+// with their length in front. arguments of any other type get formatted on
+// the spot and stored as strings. the format string has to stay alive for as
+// long as the binary_log, so use string literals. it gets checked when it's
+// first used and throws format_error like format_it::format would.
+// binary_log is not thread safe, use one per thread or per file.
+// binary_log_reader turns that back into text later. the text is exactly
+// what stack_format would have printed. tools/decode_binary_log.cpp is a
+// command line program for that
+namespace fmt
+{
+namespace detail
+{
+static constexpr char binary_log_magic[8] = { 'f', 'm', 't', 'b', 'l', 'o', 'g', '1' };
+enum binary_log_tag : unsigned char
+{
+	binary_log_define = 1,
+	binary_log_record = 2,
+};
+enum binary_argument_type : unsigned char
+{
+	binary_signed,
+	binary_unsigned,
+	binary_char,
+	binary_float,
+	binary_double,
+	binary_string,
+};
+inline char * write_varint(char * out, uint64_t value)
+{
+	for (; value >= 0x80; value >>= 7) *out++ = char(value | 0x80);
+	*out++ = char(value);
+	return out;
+}
+inline bool read_varint(const char *& in, const char * end, uint64_t & value)
+{
+	value = 0;
+	for (int shift = 0; in != end && shift < 64; shift += 7)
+	{
+		unsigned char byte = static_cast<unsigned char>(*in++);
+		value |= uint64_t(byte & 0x7f) << shift;
+		if (byte < 0x80) return true;
+	}
+	return false;
+}
+// collects a record in a small buffer so that it gets written with a single
+// call. only long strings get written on their own
+template<typename It>
+struct binary_encoder
+{
+	explicit binary_encoder(format_it<char, It> & it)
+		: it(it)
+	{
+	}
+	~binary_encoder()
+	{
+		flush();
+	}
+	void flush()
+	{
+		it.write(buffer, out);
+		out = buffer;
+	}
+	void reserve(size_t size)
+	{
+		if (size_t(buffer + sizeof(buffer) - out) < size) flush();
+	}
+	void byte(unsigned char value)
+	{
+		reserve(1);
+		*out++ = char(value);
+	}
+	void varint(uint64_t value)
+	{
+		reserve(10);
+		out = write_varint(out, value);
+	}
+	void bytes(const void * data, size_t size)
+	{
+		if (size <= sizeof(buffer) / 4)
+		{
+			reserve(size);
+			std::memcpy(out, data, size);
+			out += size;
+		}
+		else
+		{
+			flush();
+			const char * begin = static_cast<const char *>(data);
+			it.write(begin, begin + size);
+		}
+	}
+	void string(const char * data, size_t size)
+	{
+		byte(binary_string);
+		varint(size);
+		bytes(data, size);
+	}
+
+	format_it<char, It> & it;
+	char buffer[256];
+	char * out = buffer;
+};
+// the integers that fit into a varint and print as numbers
+template<typename T>
+struct is_binary_integer : std::integral_constant<bool, std::is_integral<T>::value && sizeof(T) != 1 && sizeof(T) <= sizeof(uint64_t)
+	&& !std::is_same<T, wchar_t>::value && !std::is_same<T, char16_t>::value && !std::is_same<T, char32_t>::value>
+{
+};
+// how an argument gets stored. types that aren't handled below get
+// formatted into a string
+template<typename T, typename Enable = void>
+struct binary_argument
+{
+	template<typename It>
+	static void encode(binary_encoder<It> & encoder, const T & value)
+	{
+		std::string formatted;
+		make_format_it(std::back_inserter(formatted)) = value;
+		encoder.string(formatted.data(), formatted.size());
+	}
+};
+template<typename T>
+struct binary_argument<T, typename std::enable_if<is_binary_integer<T>::value && std::is_signed<T>::value>::type>
+{
+	template<typename It>
+	static void encode(binary_encoder<It> & encoder, T value)
+	{
+		// zigzag, so that small negative numbers stay short
+		uint64_t extended = uint64_t(int64_t(value));
+		encoder.byte(binary_signed);
+		encoder.varint((extended << 1) ^ (0 - (extended >> 63)));
+	}
+};
+template<typename T>
+struct binary_argument<T, typename std::enable_if<is_binary_integer<T>::value && !std::is_signed<T>::value>::type>
+{
+	template<typename It>
+	static void encode(binary_encoder<It> & encoder, T value)
+	{
+		encoder.byte(binary_unsigned);
+		encoder.varint(value);
+	}
+};
+// bool is unsigned and prints as 0 or 1. all three char types print as
+// characters
+template<>
+struct binary_argument<bool> : binary_argument<unsigned>
+{
+};
+template<typename T>
+struct binary_argument<T, typename std::enable_if<std::is_integral<T>::value && sizeof(T) == 1 && !std::is_same<T, bool>::value>::type>
+{
+	template<typename It>
+	static void encode(binary_encoder<It> & encoder, T value)
+	{
+		encoder.byte(binary_char);
+		encoder.byte(static_cast<unsigned char>(value));
+	}
+};
+template<>
+struct binary_argument<float>
+{
+	template<typename It>
+	static void encode(binary_encoder<It> & encoder, float value)
+	{
+		encoder.byte(binary_float);
+		encoder.bytes(&value, sizeof(value));
+	}
+};
+template<>
+struct binary_argument<double>
+{
+	template<typename It>
+	static void encode(binary_encoder<It> & encoder, double value)
+	{
+		encoder.byte(binary_double);
+		encoder.bytes(&value, sizeof(value));
+	}
+};
+template<typename Traits, typename Allocator>
+struct binary_argument<std::basic_string<char, Traits, Allocator> >
+{
+	template<typename It>
+	static void encode(binary_encoder<It> & encoder, const std::basic_string<char, Traits, Allocator> & value)
+	{
+		encoder.string(value.data(), value.size());
+	}
+};
+template<>
+struct binary_argument<const char *>
+{
+	template<typename It>
+	static void encode(binary_encoder<It> & encoder, const char * value)
+	{
+		encoder.string(value, std::char_traits<char>::length(value));
+	}
+};
+template<>
+struct binary_argument<char *> : binary_argument<const char *>
+{
+};
+template<size_t Size>
+struct binary_argument<char[Size]>
+{
+	template<typename It>
+	static void encode(binary_encoder<It> & encoder, const char (&value)[Size])
+	{
+		encoder.string(value, Size - 1);
+	}
+};
+#ifdef FORMAT_STRING_VIEW
+template<typename Traits>
+struct binary_argument<std::basic_string_view<char, Traits> >
+{
+	template<typename It>
+	static void encode(binary_encoder<It> & encoder, std::basic_string_view<char, Traits> value)
+	{
+		encoder.string(value.data(), value.size());
+	}
+};
+#endif
+
+// an argument as the reader sees it
+struct binary_value
+{
+	binary_argument_type type;
+	union
+	{
+		int64_t signed_value;
+		uint64_t unsigned_value;
+		char char_value;
+		float float_value;
+		double double_value;
+	};
+	const char * string;
+	size_t string_size;
+};
+template<typename C, typename It>
+format_it<C, It> format(format_it<C, It> it, const binary_value & value)
+{
+	switch (value.type)
+	{
+	case binary_signed:
+		return format(it, static_cast<long long>(value.signed_value));
+	case binary_unsigned:
+		return format(it, static_cast<unsigned long long>(value.unsigned_value));
+	case binary_char:
+		return format(it, value.char_value);
+	case binary_float:
+		return format(it, value.float_value);
+	case binary_double:
+		return format(it, value.double_value);
+	case binary_string:
+		break;
+	}
+	return write_chars(it, value.string, value.string + value.string_size);
+}
+}
+
+template<typename It>
+struct binary_log
+{
+	// writes the file header
+	explicit binary_log(format_it<char, It> it)
+		: it(std::move(it))
+	{
+		this->it.write(detail::binary_log_magic, detail::binary_log_magic + sizeof(detail::binary_log_magic));
+	}
+
+	template<size_t FormatSize, typename... Args>
+	void format(const char (&format_string)[FormatSize], const Args &... args)
+	{
+		detail::binary_encoder<It> encoder(it);
+		uint64_t id = format_id(encoder, format_string, FormatSize - 1, int(sizeof...(Args)));
+		encoder.byte(detail::binary_log_record);
+		encoder.varint(id);
+		encoder.varint(sizeof...(Args));
+		int expand[] = { 0, (detail::binary_argument<Args>::encode(encoder, args), 0)... };
+		static_cast<void>(expand);
+	}
+
+	format_it<char, It> & output()
+	{
+		return it;
+	}
+
+private:
+	// the format string gets checked the first time it's used, so that a
+	// mistake throws here like it would in format_it::format instead of only
+	// showing up when the log is decoded
+	uint64_t format_id(detail::binary_encoder<It> & encoder, const char * format_string, size_t size, int num_args)
+	{
+		auto found = ids.find(format_string);
+		if (found != ids.end()) return found->second;
+		detail::parsed_format<char>(format_string, format_string + size).check(num_args);
+		uint64_t id = ids.size();
+		ids.emplace(format_string, id);
+		encoder.byte(detail::binary_log_define);
+		encoder.varint(id);
+		encoder.varint(size);
+		encoder.bytes(format_string, size);
+		return id;
+	}
+
+	format_it<char, It> it;
+	std::unordered_map<const char *, uint64_t> ids;
+};
+
+// reads what binary_log wrote. the input has to stay alive while the reader
+// is used
+struct binary_log_reader
+{
+	enum status
+	{
+		ok,
+		end_of_input,
+		// the rest of the input isn't a complete record, for example because
+		// the program that wrote it crashed, or the record is corrupt
+		truncated,
+		bad_header,
+	};
+
+	binary_log_reader(const char * begin, const char * end)
+		: position(begin), end(end)
+	{
+		if (size_t(end - begin) < sizeof(detail::binary_log_magic) || std::memcmp(begin, detail::binary_log_magic, sizeof(detail::binary_log_magic)) != 0) position = nullptr;
+		else position += sizeof(detail::binary_log_magic);
+	}
+
+	// formats the next record. throws format_error if the format string
+	// doesn't fit the arguments, the same way format_it::format would have.
+	// the reader continues after that record either way
+	template<typename It>
+	status render_next(format_it<char, It> & it)
+	{
+		if (!position) return bad_header;
+		for (;;)
+		{
+			if (position == end) return end_of_input;
+			const char * record = position;
+			unsigned char tag = static_cast<unsigned char>(*position++);
+			uint64_t id;
+			if (!detail::read_varint(position, end, id)) return truncate(record);
+			if (tag == detail::binary_log_define)
+			{
+				uint64_t size;
+				if (!detail::read_varint(position, end, size) || size > uint64_t(end - position)) return truncate(record);
+				// ids are handed out in order, so anything else means that
+				// the input is corrupt
+				if (id > formats.size()) return truncate(record);
+				else if (id == formats.size()) formats.emplace_back();
+				formats[id] = { position, position + size };
+				position += size;
+			}
+			else if (tag == detail::binary_log_record && id < formats.size())
+			{
+				if (!read_arguments()) return truncate(record);
+				format_record(it, formats[id].first, formats[id].second);
+				return ok;
+			}
+			else return truncate(record);
+		}
+	}
+	// the bytes that haven't been read yet
+	const char * remaining() const
+	{
+		return position;
+	}
+
+private:
+	status truncate(const char * record)
+	{
+		position = record;
+		return truncated;
+	}
+	bool read_arguments();
+	// the same rules as format_it::format
+	template<typename It>
+	void format_record(format_it<char, It> & it, const char * begin, const char * end)
+	{
+		std::vector<bool> used(arguments.size());
+		size_t size = end - begin;
+		for (size_t pos = 0; pos != size;)
+		{
+			detail::compiled_segment segment = detail::parse_compiled_segment(begin, size, pos);
+			if (segment.error != detail::compiled_segment::no_error) throw format_error(format_error::Reason(segment.error));
+			else if (segment.argument == detail::compiled_segment::literal) it.write(begin + segment.begin, begin + segment.end);
+			else if (size_t(segment.argument) >= arguments.size()) throw format_error(format_error::FormatIndexOutOfRange);
+			else
+			{
+				*it++ = arguments[segment.argument];
+				used[segment.argument] = true;
+			}
+			pos = segment.next;
+		}
+		if (std::find(used.begin(), used.end(), false) != used.end()) throw format_error(format_error::UnusedArgument);
+	}
+
+	const char * position;
+	const char * end;
+	std::vector<std::pair<const char *, const char *> > formats;
+	std::vector<detail::binary_value> arguments;
+};
+}
@@ -0,0 +1,237 @@
+/*
+This is free and unencumbered software released into the public domain.
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+For more information, please refer to <http://unlicense.org/>
+*/
+
+#include "format_cache.hpp"
+
+namespace fmt
+{
+template<>
+format_cache<char> & thread_format_cache<char>()
+{
+	static thread_local format_cache<char> cache;
+	return cache;
+}
+template<>
+format_cache<wchar_t> & thread_format_cache<wchar_t>()
+{
+	static thread_local format_cache<wchar_t> cache;
+	return cache;
+}
+}
+
+#ifndef DISABLE_GTEST
+#include <gtest/gtest.h>
+#include "stack_format.hpp"
+#include "string_format.hpp"
+#include <thread>
+namespace
+{
+// resets the cache of the current thread for one test
+struct fresh_cache
+{
+	fresh_cache(size_t capacity = fmt::format_cache<char>::default_capacity)
+	{
+		fmt::thread_format_cache<char>().clear();
+		fmt::thread_format_cache<char>().set_capacity(capacity);
+		start = fmt::thread_format_cache<char>().statistics();
+	}
+	~fresh_cache()
+	{
+		fmt::thread_format_cache<char>().clear();
+		fmt::thread_format_cache<char>().set_capacity(fmt::format_cache<char>::default_capacity);
+	}
+	uint64_t hits() const
+	{
+		return fmt::thread_format_cache<char>().statistics().hits - start.hits;
+	}
+	uint64_t misses() const
+	{
+		return fmt::thread_format_cache<char>().statistics().misses - start.misses;
+	}
+	uint64_t evictions() const
+	{
+		return fmt::thread_format_cache<char>().statistics().evictions - start.evictions;
+	}
+	fmt::format_cache_statistics start;
+};
+
+TEST(format_cache, same_output_as_format)
+{
+	fresh_cache cache;
+	std::pair<std::string, int> formats[] = { { "", 0 }, { "no arguments", 0 }, { "%0", 1 }, { "%1 %0 %1", 2 }, { "%%%0%%", 1 }, { "[%0, %1, %2]", 3 }, { "%10%9%8%7%6%5%4%3%2%1%0", 11 } };
+	for (const auto & format : formats)
+	{
+		for (int repeat = 0; repeat < 2; ++repeat)
+		{
+			std::string expected;
+			std::string cached;
+			auto expected_it = fmt::make_format_it(std::back_inserter(expected));
+			auto cached_it = fmt::make_format_it(std::back_inserter(cached));
+			switch (format.second)
+			{
+			case 0:
+				expected_it.format(format.first);
+				cached_it.format(fmt::cached(format.first));
+				break;
+			case 1:
+				expected_it.format(format.first, 1.5);
+				cached_it.format(fmt::cached(format.first), 1.5);
+				break;
+			case 2:
+				expected_it.format(format.first, "a", 'b');
+				cached_it.format(fmt::cached(format.first), "a", 'b');
+				break;
+			case 3:
+				expected_it.format(format.first, 1, std::string("two"), 3u);
+				cached_it.format(fmt::cached(format.first), 1, std::string("two"), 3u);
+				break;
+			default:
+				expected_it.format(format.first, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10);
+				cached_it.format(fmt::cached(format.first), 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10);
+				break;
+			}
+			ASSERT_EQ(expected, cached);
+		}
+	}
+	ASSERT_EQ(7u, cache.misses());
+	ASSERT_EQ(7u, cache.hits());
+}
+TEST(format_cache, works_with_other_sinks)
+{
+	fresh_cache cache;
+	std::string format = "%0: %1";
+	ASSERT_EQ("a: 1", fmt::stack_format<64>(fmt::cached(format), "a", 1));
+	ASSERT_EQ("b: 2", fmt::string_format(fmt::cached(format), "b", 2));
+	std::wstring wide = L"%0: %1";
+	ASSERT_EQ(L"c: 3", fmt::string_format<std::wstring>(fmt::cached(wide), L"c", 3));
+	ASSERT_EQ(1u, cache.misses());
+	ASSERT_EQ(1u, cache.hits());
+}
+fmt::format_error::Reason cached_error(const char * format, int num_arguments, std::string & out)
+{
+	auto it = fmt::make_format_it(std::back_inserter(out));
+	try
+	{
+		if (num_arguments == 0) it.format(fmt::cached(format));
+		else if (num_arguments == 1) it.format(fmt::cached(format), 1);
+		else it.format(fmt::cached(format), 1, 2);
+	}
+	catch (const fmt::format_error & error)
+	{
+		return error.reason();
+	}
+	ADD_FAILURE() << format << " didn't throw";
+	return fmt::format_error::UnusedArgument;
+}
+TEST(format_cache, errors)
+{
+	fresh_cache cache;
+	for (int repeat = 0; repeat < 2; ++repeat)
+	{
+		std::string out;
+		ASSERT_EQ(fmt::format_error::OpenPercentAtEndOfInput, cached_error("abc%", 0, out));
+		ASSERT_EQ(fmt::format_error::PercentNotFollowedByNumber, cached_error("abc%x", 0, out));
+		ASSERT_EQ(fmt::format_error::FormatIndexOutOfRange, cached_error("abc%1", 1, out));
+		ASSERT_EQ(fmt::format_error::UnusedArgument, cached_error("ab%1", 2, out));
+		ASSERT_EQ(fmt::format_error::UnusedArgument, cached_error("abc", 1, out));
+		// too large to be an index. these used to overflow, wrap around to a
+		// literal or size the table of used arguments by the index
+		ASSERT_EQ(fmt::format_error::FormatIndexOutOfRange, cached_error("%2147483648", 1, out));
+		ASSERT_EQ(fmt::format_error::FormatIndexOutOfRange, cached_error("%4294967295", 1, out));
+		ASSERT_EQ(fmt::format_error::FormatIndexOutOfRange, cached_error("%1000000000", 1, out));
+		// the cache checks everything before it writes
+		ASSERT_EQ("", out);
+	}
+	ASSERT_EQ(8u, cache.misses());
+	ASSERT_EQ(8u, cache.hits());
+}
+TEST(format_cache, changed_string)
+{
+	fresh_cache cache;
+	std::string format = "%0 apples";
+	ASSERT_EQ("3 apples", fmt::string_format(fmt::cached(format), 3));
+	format[3] = 'b';
+	ASSERT_EQ("3 bpples", fmt::string_format(fmt::cached(format), 3));
+	ASSERT_EQ(2u, cache.misses());
+	ASSERT_EQ(0u, cache.hits());
+	ASSERT_EQ(1u, fmt::thread_format_cache<char>().statistics().entries);
+}
+TEST(format_cache, evicts_least_recently_used)
+{
+	const char * formats[] = { "first %0", "second %0", "third %0" };
+	size_t entry_size = fmt::detail::parsed_format<char>(formats[1], formats[1] + 9).memory_size();
+	fresh_cache cache(entry_size * 2 + entry_size / 2);
+	fmt::string_format(fmt::cached(formats[0]), 0);
+	fmt::string_format(fmt::cached(formats[1]), 0);
+	fmt::string_format(fmt::cached(formats[0]), 0);
+	// evicts the second one, which was used longest ago
+	fmt::string_format(fmt::cached(formats[2]), 0);
+	ASSERT_EQ(1u, cache.evictions());
+	fmt::string_format(fmt::cached(formats[0]), 0);
+	fmt::string_format(fmt::cached(formats[2]), 0);
+	ASSERT_EQ(3u, cache.hits());
+	fmt::string_format(fmt::cached(formats[1]), 0);
+	ASSERT_EQ(4u, cache.misses());
+	ASSERT_EQ(2u, fmt::thread_format_cache<char>().statistics().entries);
+	ASSERT_LE(fmt::thread_format_cache<char>().statistics().bytes, fmt::thread_format_cache<char>().get_capacity());
+}
+TEST(format_cache, disabled)
+{
+	fresh_cache cache(0);
+	for (int i = 0; i < 3; ++i) ASSERT_EQ("1", fmt::string_format(fmt::cached("%0"), 1));
+	ASSERT_EQ(3u, cache.misses());
+	ASSERT_EQ(0u, fmt::thread_format_cache<char>().statistics().entries);
+}
+struct uses_cache_while_formatted
+{
+	int depth;
+};
+template<typename C, typename It>
+fmt::format_it<C, It> format(fmt::format_it<C, It> it, const uses_cache_while_formatted & self)
+{
+	std::string format = fmt::string_format("<%0 %%0>", self.depth);
+	if (self.depth == 0) return it.format(fmt::cached(format), "end");
+	else return it.format(fmt::cached(format), uses_cache_while_formatted{ self.depth - 1 });
+}
+TEST(format_cache, nested)
+{
+	// only room for one entry, so every nested format evicts the outer one
+	fresh_cache cache(fmt::detail::parsed_format<char>("<0 %0>", "<0 %0>" + 6).memory_size());
+	ASSERT_EQ("<3 <2 <1 <0 end>>>>", fmt::string_format("%0", uses_cache_while_formatted{ 3 }));
+	ASSERT_EQ(3u, cache.evictions());
+}
+TEST(format_cache, per_thread)
+{
+	fresh_cache cache;
+	fmt::string_format(fmt::cached("%0"), 1);
+	fmt::format_cache_statistics other;
+	std::thread([&]
+	{
+		fmt::string_format(fmt::cached("%0"), 1);
+		other = fmt::thread_format_cache<char>().statistics();
+	}).join();
+	ASSERT_EQ(1u, other.misses);
+	ASSERT_EQ(0u, other.hits);
+}
+}
+#endif
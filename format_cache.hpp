@@ -0,0 +1,255 @@
+/*
+This is free and unencumbered software released into the public domain.
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+For more information, please refer to <http://unlicense.org/>
+*/
+
+#pragma once
+
+#include "format_compile.hpp"
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// use like this:
+// const std::string & message = translations.get("new_messages"); // "%0, you have %1 new messages"
+// it.format(fmt::cached(message), name, count);
+// for format strings that aren't literals and so can't go through
+// FMT_COMPILE. the first use on a thread splits the format string into
+// literal text and arguments and checks which arguments it uses. later uses
+// of the same string only look at each segment once and check the number
+// of arguments. the errors are the same as for format_it::format, but they
+// are thrown before anything is written.
+// the cache is per thread and per character type, holds the most recently
+// used format strings up to a size in bytes, and is looked up by the address
+// of the format string. the content is compared too, so a string that
+// changed or a new string at an old address just gets parsed again
+namespace fmt
+{
+namespace detail
+{
+template<typename C>
+struct parsed_format
+{
+	std::basic_string<C> text;
+	std::vector<compiled_segment> segments;
+	int error = compiled_segment::no_error;
+	int max_argument = -1;
+	int num_arguments = 0;
+
+	parsed_format(const C * begin, const C * end)
+		: text(begin, end)
+	{
+		std::vector<bool> used;
+		for (size_t pos = 0; pos != text.size();)
+		{
+			compiled_segment segment = parse_compiled_segment(text.data(), text.size(), pos);
+			if (segment.error != compiled_segment::no_error)
+			{
+				error = segment.error;
+				break;
+			}
+			if (segment.argument != compiled_segment::literal)
+			{
+				if (segment.argument >= int(used.size())) used.resize(segment.argument + 1);
+				if (!used[segment.argument]) ++num_arguments;
+				used[segment.argument] = true;
+				max_argument = std::max(max_argument, segment.argument);
+			}
+			segments.push_back(segment);
+			pos = segment.next;
+		}
+	}
+	void check(int num_args) const
+	{
+		if (error != compiled_segment::no_error) throw format_error(format_error::Reason(error));
+		else if (max_argument >= num_args) throw format_error(format_error::FormatIndexOutOfRange);
+		else if (num_arguments != num_args) throw format_error(format_error::UnusedArgument);
+	}
+	// roughly what this costs in the cache, including the bookkeeping
+	size_t memory_size() const
+	{
+		return sizeof(*this) + 64 + text.capacity() * sizeof(C) + segments.capacity() * sizeof(compiled_segment);
+	}
+};
+}
+
+struct format_cache_statistics
+{
+	uint64_t hits = 0;
+	uint64_t misses = 0;
+	uint64_t evictions = 0;
+	size_t entries = 0;
+	size_t bytes = 0;
+};
+
+template<typename C>
+struct format_cache
+{
+	static constexpr size_t default_capacity = 64 * 1024;
+
+	format_cache() = default;
+	format_cache(const format_cache &) = delete;
+	format_cache & operator=(const format_cache &) = delete;
+
+	// the result stays valid while the cache evicts it, so formatting an
+	// argument can use the cache again
+	std::shared_ptr<const detail::parsed_format<C> > get(const C * begin, const C * end)
+	{
+		auto found = by_address.find(begin);
+		if (found != by_address.end())
+		{
+			entry & cached = found->second;
+			const detail::parsed_format<C> & parsed = *cached.parsed;
+			if (parsed.text.size() == size_t(end - begin) && std::equal(begin, end, parsed.text.data()))
+			{
+				++stats.hits;
+				unlink(cached);
+				link_newest(cached);
+				return cached.parsed;
+			}
+			erase(cached);
+		}
+		++stats.misses;
+		std::shared_ptr<const detail::parsed_format<C> > parsed = std::make_shared<detail::parsed_format<C> >(begin, end);
+		size_t size = parsed->memory_size();
+		if (size > capacity) return parsed;
+		while (stats.bytes + size > capacity) evict_oldest();
+		entry & added = by_address[begin];
+		added.address = begin;
+		added.parsed = parsed;
+		link_newest(added);
+		stats.bytes += size;
+		++stats.entries;
+		return parsed;
+	}
+
+	format_cache_statistics statistics() const
+	{
+		return stats;
+	}
+	// evicts entries until the cache fits. format strings that are larger
+	// than the capacity are parsed every time. 0 turns the cache off
+	void set_capacity(size_t bytes)
+	{
+		capacity = bytes;
+		while (stats.bytes > capacity) evict_oldest();
+	}
+	size_t get_capacity() const
+	{
+		return capacity;
+	}
+	void clear()
+	{
+		by_address.clear();
+		newest = oldest = nullptr;
+		stats.entries = 0;
+		stats.bytes = 0;
+	}
+
+private:
+	// the entries are also a list from the most recently used to the least
+	// recently used. the nodes of an unordered_map don't move, so the list
+	// can point into it
+	struct entry
+	{
+		const C * address = nullptr;
+		std::shared_ptr<const detail::parsed_format<C> > parsed;
+		entry * newer = nullptr;
+		entry * older = nullptr;
+	};
+
+	void link_newest(entry & to_link)
+	{
+		to_link.newer = nullptr;
+		to_link.older = newest;
+		if (newest) newest->newer = &to_link;
+		else oldest = &to_link;
+		newest = &to_link;
+	}
+	void unlink(entry & to_unlink)
+	{
+		if (to_unlink.newer) to_unlink.newer->older = to_unlink.older;
+		else newest = to_unlink.older;
+		if (to_unlink.older) to_unlink.older->newer = to_unlink.newer;
+		else oldest = to_unlink.newer;
+	}
+	void erase(entry & to_erase)
+	{
+		stats.bytes -= to_erase.parsed->memory_size();
+		--stats.entries;
+		unlink(to_erase);
+		by_address.erase(to_erase.address);
+	}
+	void evict_oldest()
+	{
+		++stats.evictions;
+		erase(*oldest);
+	}
+
+	std::unordered_map<const C *, entry> by_address;
+	entry * newest = nullptr;
+	entry * oldest = nullptr;
+	format_cache_statistics stats;
+	size_t capacity = default_capacity;
+};
+template<typename C>
+constexpr size_t format_cache<C>::default_capacity;
+
+// the cache of the current thread
+template<typename C>
+format_cache<C> & thread_format_cache();
+template<>
+format_cache<char> & thread_format_cache<char>();
+template<>
+format_cache<wchar_t> & thread_format_cache<wchar_t>();
+
+template<typename C>
+struct cached_format_string
+{
+	const C * begin;
+	const C * end;
+
+	template<typename It, typename... Args>
+	void format(format_it<C, It> & it, const Args &... args) const
+	{
+		std::shared_ptr<const detail::parsed_format<C> > parsed = thread_format_cache<C>().get(begin, end);
+		parsed->check(int(sizeof...(Args)));
+		detail::format_arguments<C, It, Args...> arguments(args...);
+		const C * text = parsed->text.data();
+		for (const detail::compiled_segment & segment : parsed->segments)
+		{
+			if (segment.argument == detail::compiled_segment::literal) it.write(text + segment.begin, text + segment.end);
+			else arguments.format(it, segment.argument);
+		}
+	}
+};
+template<typename C, typename Traits, typename Allocator>
+cached_format_string<C> cached(const std::basic_string<C, Traits, Allocator> & format_string)
+{
+	return { format_string.data(), format_string.data() + format_string.size() };
+}
+template<typename C>
+cached_format_string<C> cached(const C * format_string)
+{
+	return { format_string, format_string + std::char_traits<C>::length(format_string) };
+}
+}
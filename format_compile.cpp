@@ -0,0 +1,83 @@
+/*
+This is free and unencumbered software released into the public domain.
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+For more information, please refer to <http://unlicense.org/>
+*/
+
+#include "format_compile.hpp"
+
+#ifndef DISABLE_GTEST
+#include <gtest/gtest.h>
+#include "stack_format.hpp"
+namespace
+{
+TEST(format_compile, format_to_string)
+{
+	std::string test;
+	fmt::make_format_it<char>(std::back_inserter(test)).format(FMT_COMPILE("[%0, %1, %2]"), "Hello", "World", 5);
+	ASSERT_EQ("[Hello, World, 5]", test);
+}
+TEST(format_compile, no_arguments)
+{
+	fmt::stack_format<1024> hi(FMT_COMPILE("Hello, World!"));
+	ASSERT_EQ("Hello, World!", hi);
+	fmt::stack_format<1024> empty(FMT_COMPILE(""));
+	ASSERT_EQ("", empty);
+}
+TEST(format_compile, wchar)
+{
+	std::wstring test;
+	fmt::make_format_it<wchar_t>(std::back_inserter(test)).format(FMT_COMPILE(L"%0: %1, %2, %3"), 5, L"bar", "baz", 0.7);
+	ASSERT_EQ(L"5: bar, baz, 0.7", test);
+}
+TEST(format_compile, percent)
+{
+	fmt::stack_format<1024> foo(FMT_COMPILE("%%%0%%%%"), 10);
+	ASSERT_EQ("%10%%", foo);
+}
+TEST(format_compile, order_independent)
+{
+	fmt::stack_format<1024> foo(FMT_COMPILE("%1%0%0%1"), "foo", std::string("bar"));
+	ASSERT_EQ("barfoofoobar", foo);
+}
+TEST(format_compile, multidigit_index)
+{
+	fmt::stack_format<1024> foo(FMT_COMPILE("%0%1%2%3%4%5%6%7%8%9%10%11%12%13%00%02"), 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13);
+	ASSERT_EQ("01234567891011121302", foo);
+}
+TEST(format_compile, overflow)
+{
+	fmt::stack_format<4> foo(FMT_COMPILE("%0, %1"), 10000.0f, 66.0f);
+	ASSERT_EQ("10000, 66", foo);
+}
+TEST(format_compile, segments)
+{
+	static_assert(fmt::detail::count_compiled_segments("a%0b%%c", 7) == 5, "a, %0, b, %, c");
+	static_assert(fmt::detail::compiled_segment_at("a%0b%%c", 7, 1).argument == 0, "second segment is %0");
+	static_assert(fmt::detail::first_compiled_error("a%", 2) == fmt::format_error::OpenPercentAtEndOfInput, "open percent");
+	static_assert(fmt::detail::first_compiled_error("a%b", 3) == fmt::format_error::PercentNotFollowedByNumber, "percent without number");
+	static_assert(fmt::detail::max_compiled_argument("%3%1", 4) == 3, "max argument");
+	static_assert(fmt::detail::max_compiled_argument("%65535", 6) == 65535, "largest index");
+	static_assert(fmt::detail::first_compiled_error("%65536", 6) == fmt::format_error::FormatIndexOutOfRange, "index too large");
+	static_assert(fmt::detail::first_compiled_error("%2147483648", 11) == fmt::format_error::FormatIndexOutOfRange, "index doesn't overflow");
+	static_assert(!fmt::detail::uses_all_compiled_arguments("%0%2", 4, 3), "unused argument");
+}
+}
+#endif
@@ -0,0 +1,256 @@
+/*
+This is free and unencumbered software released into the public domain.
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+For more information, please refer to <http://unlicense.org/>
+*/
+
+#pragma once
+
+#include "format_it.hpp"
+#include <tuple>
+#include <utility>
+#include <type_traits>
+
+// use like this:
+// fmt::stack_format<1024> foo(FMT_COMPILE("%0, %1"), 5, "bar");
+// the format string gets split into literal text and arguments at compile
+// time, and mistakes in the format string are compile errors instead of
+// exceptions. the format string has to be a string literal
+#define FMT_COMPILE(format_string)\
+	([]\
+	{\
+		struct compiled_string\
+		{\
+			static constexpr decltype(format_string) & get()\
+			{\
+				return format_string;\
+			}\
+		};\
+		return ::fmt::compiled_format<compiled_string>();\
+	}())
+
+namespace fmt
+{
+namespace detail
+{
+// a piece of the format string. either literal text in the range
+// [begin, end) or a reference to the argument at index argument
+struct compiled_segment
+{
+	size_t begin;
+	size_t end;
+	int argument;
+	int error;
+	size_t next;
+
+	static constexpr int literal = -1;
+	static constexpr int no_error = -1;
+	// larger indices are a FormatIndexOutOfRange error while parsing, so
+	// that the index can't overflow and nobody sizes a table by it
+	static constexpr int max_argument = 65535;
+};
+template<typename C>
+constexpr bool compiled_is_digit(C c)
+{
+	return c >= C('0') && c <= C('9');
+}
+template<typename C>
+constexpr compiled_segment parse_compiled_segment(const C * str, size_t size, size_t pos)
+{
+	if (str[pos] != C('%'))
+	{
+		size_t end = pos;
+		while (end != size && str[end] != C('%')) ++end;
+		return { pos, end, compiled_segment::literal, compiled_segment::no_error, end };
+	}
+	size_t next = pos + 1;
+	if (next == size)
+	{
+		return { pos, next, compiled_segment::literal, format_error::OpenPercentAtEndOfInput, size };
+	}
+	else if (str[next] == C('%'))
+	{
+		return { next, next + 1, compiled_segment::literal, compiled_segment::no_error, next + 1 };
+	}
+	else if (!compiled_is_digit(str[next]))
+	{
+		return { pos, next, compiled_segment::literal, format_error::PercentNotFollowedByNumber, size };
+	}
+	int argument = 0;
+	for (; next != size && compiled_is_digit(str[next]); ++next)
+	{
+		argument *= 10;
+		argument += str[next] - C('0');
+		if (argument > compiled_segment::max_argument)
+		{
+			return { pos, next, compiled_segment::literal, format_error::FormatIndexOutOfRange, size };
+		}
+	}
+	return { pos, next, argument, compiled_segment::no_error, next };
+}
+template<typename C>
+constexpr size_t count_compiled_segments(const C * str, size_t size)
+{
+	size_t count = 0;
+	for (size_t pos = 0; pos != size; pos = parse_compiled_segment(str, size, pos).next)
+	{
+		++count;
+	}
+	return count;
+}
+template<typename C>
+constexpr compiled_segment compiled_segment_at(const C * str, size_t size, size_t index)
+{
+	compiled_segment segment = parse_compiled_segment(str, size, 0);
+	for (; index != 0; --index)
+	{
+		segment = parse_compiled_segment(str, size, segment.next);
+	}
+	return segment;
+}
+template<typename C>
+constexpr int first_compiled_error(const C * str, size_t size)
+{
+	for (size_t pos = 0; pos != size;)
+	{
+		compiled_segment segment = parse_compiled_segment(str, size, pos);
+		if (segment.error != compiled_segment::no_error) return segment.error;
+		pos = segment.next;
+	}
+	return compiled_segment::no_error;
+}
+template<typename C>
+constexpr int max_compiled_argument(const C * str, size_t size)
+{
+	int result = -1;
+	for (size_t pos = 0; pos != size;)
+	{
+		compiled_segment segment = parse_compiled_segment(str, size, pos);
+		if (segment.argument > result) result = segment.argument;
+		pos = segment.next;
+	}
+	return result;
+}
+template<typename C>
+constexpr bool uses_compiled_argument(const C * str, size_t size, int argument)
+{
+	for (size_t pos = 0; pos != size;)
+	{
+		compiled_segment segment = parse_compiled_segment(str, size, pos);
+		if (segment.argument == argument) return true;
+		pos = segment.next;
+	}
+	return false;
+}
+template<typename C>
+constexpr size_t count_compiled_argument_uses(const C * str, size_t size, int argument)
+{
+	size_t count = 0;
+	for (size_t pos = 0; pos != size;)
+	{
+		compiled_segment segment = parse_compiled_segment(str, size, pos);
+		if (segment.argument == argument) ++count;
+		pos = segment.next;
+	}
+	return count;
+}
+template<typename C>
+constexpr size_t compiled_literal_size(const C * str, size_t size)
+{
+	size_t count = 0;
+	for (size_t pos = 0; pos != size;)
+	{
+		compiled_segment segment = parse_compiled_segment(str, size, pos);
+		if (segment.argument == compiled_segment::literal) count += segment.end - segment.begin;
+		pos = segment.next;
+	}
+	return count;
+}
+template<typename C>
+constexpr bool uses_all_compiled_arguments(const C * str, size_t size, int num_arguments)
+{
+	for (int i = 0; i < num_arguments; ++i)
+	{
+		if (!uses_compiled_argument(str, size, i)) return false;
+	}
+	return true;
+}
+}
+
+template<typename S>
+struct compiled_format
+{
+	typedef typename std::remove_cv<typename std::remove_reference<decltype(S::get()[0])>::type>::type char_type;
+	static constexpr size_t size = sizeof(S::get()) / sizeof(char_type) - 1;
+	static constexpr size_t num_segments = detail::count_compiled_segments(S::get(), size);
+
+	template<typename C, typename It, typename... Args>
+	static void format(format_it<C, It> & it, const Args &... args)
+	{
+		static_assert(detail::first_compiled_error(S::get(), size) != format_error::OpenPercentAtEndOfInput, "A percent sign '%' was used at the end of the sequence without a number following it. If you intended to print a percent sign use two percents %%");
+		static_assert(detail::first_compiled_error(S::get(), size) != format_error::PercentNotFollowedByNumber, "A percent sign '%' was not followed by a number. If you intended to print a percent sign use two percents %%");
+		static_assert(detail::first_compiled_error(S::get(), size) != format_error::FormatIndexOutOfRange && detail::max_compiled_argument(S::get(), size) < int(sizeof...(Args)), "Format index out of range");
+		static_assert(detail::uses_all_compiled_arguments(S::get(), size, int(sizeof...(Args))), "Not all arguments were used in the format string");
+		format_segments(it, std::make_index_sequence<num_segments>(), std::tie(args...));
+	}
+	// the most characters that this can produce for the given argument
+	// types. see max_formatted_size
+	template<typename... Args>
+	static constexpr size_t max_size()
+	{
+		return max_size(static_cast<std::tuple<Args...> *>(nullptr), std::index_sequence_for<Args...>());
+	}
+
+private:
+	template<typename... Args, size_t... Indices>
+	static constexpr size_t max_size(std::tuple<Args...> *, std::index_sequence<Indices...>)
+	{
+		size_t sizes[] = { 0, (detail::count_compiled_argument_uses(S::get(), size, int(Indices)) * ::fmt::max_formatted_size<Args>::value)... };
+		size_t result = detail::compiled_literal_size(S::get(), size);
+		for (size_t size : sizes) result += size;
+		return result;
+	}
+	template<size_t Index>
+	struct segment
+	{
+		static constexpr detail::compiled_segment value = detail::compiled_segment_at(S::get(), size, Index);
+	};
+
+	template<typename C, typename It, size_t... Indices, typename Tuple>
+	static void format_segments(format_it<C, It> & it, std::index_sequence<Indices...>, const Tuple & args)
+	{
+		int expand[] = { 0, (format_segment<Indices>(it, std::integral_constant<int, segment<Indices>::value.argument>(), args), 0)... };
+		static_cast<void>(expand);
+	}
+	template<size_t Index, typename C, typename It, typename Tuple>
+	static void format_segment(format_it<C, It> & it, std::integral_constant<int, detail::compiled_segment::literal>, const Tuple &)
+	{
+		it.write(S::get() + segment<Index>::value.begin, S::get() + segment<Index>::value.end);
+	}
+	template<size_t Index, typename C, typename It, int Argument, typename Tuple>
+	static void format_segment(format_it<C, It> & it, std::integral_constant<int, Argument>, const Tuple & args)
+	{
+		it = std::get<Argument>(args);
+	}
+};
+template<typename S>
+template<size_t Index>
+constexpr detail::compiled_segment compiled_format<S>::segment<Index>::value;
+}
@@ -0,0 +1,156 @@
+/*
+This is free and unencumbered software released into the public domain.
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+For more information, please refer to <http://unlicense.org/>
+*/
+
+#include "format_fd.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <sys/uio.h>
+
+namespace fmt
+{
+constexpr size_t fd_writer::default_buffer_size;
+constexpr size_t fd_writer::zero_copy_size;
+
+static int write_all(int fd, iovec * iov, int count)
+{
+	while (count)
+	{
+		ssize_t written = ::writev(fd, iov, count);
+		if (written < 0)
+		{
+			if (errno == EINTR) continue;
+			return errno;
+		}
+		// a partial write. skip what made it and try again with the rest
+		for (; count && size_t(written) >= iov->iov_len; ++iov, --count)
+		{
+			written -= iov->iov_len;
+		}
+		if (count)
+		{
+			iov->iov_base = static_cast<char *>(iov->iov_base) + written;
+			iov->iov_len -= written;
+		}
+	}
+	return 0;
+}
+
+fd_writer::fd_writer(int fd, size_t buffer_size)
+	: _fd(fd), capacity(std::max(buffer_size, zero_copy_size)), buffer(new char[capacity])
+{
+}
+fd_writer::~fd_writer()
+{
+	flush();
+}
+void fd_writer::flush()
+{
+	write_through(nullptr, nullptr);
+}
+void fd_writer::write_through(const char * begin, const char * end)
+{
+	iovec iov[2] =
+	{
+		{ buffer.get(), size },
+		{ const_cast<char *>(begin), size_t(end - begin) },
+	};
+	size = 0;
+	if (!_error && (iov[0].iov_len || iov[1].iov_len)) _error = write_all(_fd, iov, 2);
+}
+}
+
+#ifndef DISABLE_GTEST
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <string>
+#include <unistd.h>
+namespace
+{
+struct temporary_file
+{
+	temporary_file()
+		: file(std::tmpfile())
+	{
+	}
+	~temporary_file()
+	{
+		std::fclose(file);
+	}
+	int fd() const
+	{
+		return fileno(file);
+	}
+	std::string contents() const
+	{
+		std::string result(size_t(lseek(fd(), 0, SEEK_END)), '\0');
+		ssize_t num_read = pread(fd(), &result[0], result.size(), 0);
+		result.resize(num_read < 0 ? 0 : size_t(num_read));
+		return result;
+	}
+	FILE * file;
+};
+TEST(format_fd, buffered)
+{
+	temporary_file file;
+	fmt::fd_writer writer(file.fd());
+	auto it = fmt::make_format_it(writer.sink());
+	it.format("%0 %1\n", "GET", 200);
+	it.print(1.5, nullptr);
+	ASSERT_EQ("", file.contents());
+	writer.flush();
+	ASSERT_EQ("GET 200\n1.5 nullptr", file.contents());
+	ASSERT_EQ(0, writer.error());
+}
+TEST(format_fd, zero_copy)
+{
+	temporary_file file;
+	std::string expected;
+	{
+		fmt::fd_writer writer(file.fd(), 1);
+		auto it = fmt::make_format_it(writer.sink());
+		std::string large(fmt::fd_writer::zero_copy_size, 'x');
+		for (int i = 0; i < 100; ++i)
+		{
+			it.format("%0: %1 %2\n", i, large, fmt::hex(i));
+			char hex[16];
+			std::snprintf(hex, sizeof(hex), "%x", i);
+			expected += std::to_string(i) + ": " + large + ' ' + hex + '\n';
+		}
+		// the part after the last large string is still buffered
+		ASSERT_GT(expected.size(), file.contents().size());
+	}
+	ASSERT_EQ(expected, file.contents());
+}
+TEST(format_fd, error)
+{
+	int fds[2];
+	ASSERT_EQ(0, pipe(fds));
+	close(fds[1]);
+	fmt::fd_writer writer(fds[1]);
+	fmt::make_format_it(writer.sink()).print("closed");
+	writer.flush();
+	ASSERT_EQ(EBADF, writer.error());
+	close(fds[0]);
+}
+}
+#endif
@@ -0,0 +1,133 @@
+/*
+This is free and unencumbered software released into the public domain.
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+For more information, please refer to <http://unlicense.org/>
+*/
+
+#pragma once
+
+#include "format_it.hpp"
+#include <iterator>
+#include <memory>
+#include <cstring>
+
+// formats straight into a POSIX file descriptor:
+// fmt::fd_writer log(fd);
+// auto it = fmt::make_format_it(log.sink());
+// it.format("%0 %1 %2\n", method, url, status);
+// short writes get copied into a buffer. writes of at least zero_copy_size
+// characters don't get copied: they go out in a single writev together with
+// whatever is in the buffer. the buffer gets written when it's full, on
+// flush() and in the destructor. the file descriptor doesn't get closed.
+// if a write fails, error() returns its errno and all output after that is
+// dropped, like with the error flag of a FILE
+namespace fmt
+{
+struct fd_sink;
+struct fd_writer
+{
+	static constexpr size_t default_buffer_size = 64 * 1024;
+	static constexpr size_t zero_copy_size = 1024;
+
+	explicit fd_writer(int fd, size_t buffer_size = default_buffer_size);
+	~fd_writer();
+	fd_writer(const fd_writer &) = delete;
+	fd_writer & operator=(const fd_writer &) = delete;
+
+	fd_sink sink();
+	void flush();
+	int fd() const
+	{
+		return _fd;
+	}
+	int error() const
+	{
+		return _error;
+	}
+
+private:
+	friend struct fd_sink;
+	// writes the buffer followed by [begin, end)
+	void write_through(const char * begin, const char * end);
+
+	int _fd;
+	int _error = 0;
+	size_t size = 0;
+	size_t capacity;
+	std::unique_ptr<char[]> buffer;
+};
+struct fd_sink : std::iterator<std::output_iterator_tag, void, void, void, void>
+{
+	explicit fd_sink(fd_writer & writer)
+		: writer(&writer)
+	{
+	}
+	fd_sink & operator=(char c)
+	{
+		if (writer->size == writer->capacity) writer->flush();
+		writer->buffer[writer->size++] = c;
+		return *this;
+	}
+	void write(const char * begin, const char * end)
+	{
+		size_t size = end - begin;
+		if (size >= fd_writer::zero_copy_size) writer->write_through(begin, end);
+		else
+		{
+			if (size > writer->capacity - writer->size) writer->flush();
+			std::memcpy(writer->buffer.get() + writer->size, begin, size);
+			writer->size += size;
+		}
+	}
+	// see detail::bounded_format
+	char * unchecked_begin(size_t size)
+	{
+		if (size > writer->capacity - writer->size)
+		{
+			writer->flush();
+			if (size > writer->capacity) return nullptr;
+		}
+		return writer->buffer.get() + writer->size;
+	}
+	void unchecked_end(char * end)
+	{
+		writer->size = end - writer->buffer.get();
+	}
+	fd_sink & operator*()
+	{
+		return *this;
+	}
+	fd_sink & operator++()
+	{
+		return *this;
+	}
+	fd_sink & operator++(int)
+	{
+		return *this;
+	}
+
+private:
+	fd_writer * writer;
+};
+inline fd_sink fd_writer::sink()
+{
+	return fd_sink(*this);
+}
+}
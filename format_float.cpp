@@ -27,6 +27,8 @@ For more information, please refer to <http://unlicense.org/>
 #include <gtest/gtest.h>
 #include "stack_format.hpp"
 #include <cstdio>
+#include <cstring>
+#include <random>
 
 namespace
 {
@@ -97,6 +99,33 @@ inline bool double_exact_equal(double a, double b)
 	return TestPrecision(value);
 }
 
+::testing::AssertionResult TestFloatPrinting(float value)
+{
+	double as_double = value;
+	char buffer[64];
+	int printed = snprintf(buffer, sizeof(buffer) / sizeof(*buffer), "%g, %.3g, %.9g", as_double, as_double, as_double);
+	fmt::stack_format<1024> formatted("%0, %1, %2", value, fmt::precise_float(value, 3), fmt::precise_float(value, 9));
+	if (printed != int(formatted.size()) || !std::equal(formatted.begin(), formatted.end(), buffer))
+	{
+		return ::testing::AssertionFailure() << "Float " << value << " printed as " << buffer << " using snprintf and as " << formatted.c_str() << " using format_it. They should be equal";
+	}
+	fmt::stack_print<1024> padded(fmt::pad_float(value, 10));
+	fmt::stack_print<1024> padded_double(fmt::pad_float(as_double, 10));
+	if (padded.size() != padded_double.size() || !std::equal(padded.begin(), padded.end(), padded_double.begin()))
+	{
+		return ::testing::AssertionFailure() << "Float " << value << " padded as " << padded.c_str() << " but as double it is " << padded_double.c_str();
+	}
+	char ecma_buffer[64];
+	double_conversion::StringBuilder builder(ecma_buffer, sizeof(ecma_buffer) / sizeof(*ecma_buffer));
+	double_conversion::DoubleToStringConverter::EcmaScriptConverter().ToShortestSingle(value, builder);
+	fmt::stack_print<1024> nodrift(fmt::nodrift_float(value));
+	if (!(nodrift == builder.Finalize()))
+	{
+		return ::testing::AssertionFailure() << "Float " << value << " printed as " << nodrift.c_str() << " using nodrift_float and as " << ecma_buffer << " using double_conversion";
+	}
+	return ::testing::AssertionSuccess();
+}
+
 TEST(format_float, zeros)
 {
 	ASSERT_TRUE(TestDoublePrinting(0.0));
@@ -217,66 +246,168 @@ TEST(format_float, fixed)
 	ASSERT_EQ("99999963865.11612", fmt::stack_print<1024>(fmt::float_as_fixed(9.9999963865116115e10)));
 	ASSERT_EQ("378350585367700600000000000000000000000000000", fmt::stack_print<1024>(fmt::float_as_fixed(3.7835058536770061e44)));
 }
-
-struct UnsignedAsFloat
+TEST(format_float, nodrift_matches_ecma_script_converter)
 {
-	UnsignedAsFloat(unsigned value)
-		: as_unsigned(value)
+	std::mt19937_64 randomness(5);
+	std::vector<double> values = { 0.0, -0.0, 0.0 / 0.0, std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity(), 1e-7, 1e-6, 1e20, 1e21, 123e-9, 5e-324, 1.5e-320 };
+	for (int i = 0; i < 10000; ++i)
 	{
+		uint64_t bits = randomness();
+		double value;
+		std::memcpy(&value, &bits, sizeof(value));
+		values.push_back(value);
+		values.push_back(static_cast<double>(static_cast<int>(bits)) * 1e-3);
 	}
-
-	union
+	for (double value : values)
 	{
-		float as_float;
-		unsigned as_unsigned;
-	};
-};
-
-constexpr unsigned num_iterations = 200000;
-TEST(format_float, DISABLED_printf_performance)
+		char buffer[128];
+		double_conversion::StringBuilder builder(buffer, sizeof(buffer) / sizeof(*buffer));
+		double_conversion::DoubleToStringConverter::EcmaScriptConverter().ToShortest(value, builder);
+		ASSERT_EQ(builder.Finalize(), fmt::stack_print<1024>(fmt::nodrift_float(value)));
+	}
+}
+std::vector<double> random_doubles(size_t count)
 {
-	for (unsigned i = 0; i < num_iterations; ++i)
+	std::mt19937_64 randomness(5);
+	std::vector<double> result;
+	for (size_t i = 0; i < count; ++i)
 	{
-		char buffer[1024];
-		snprintf(buffer, sizeof(buffer) / sizeof(*buffer), "%g, %g, %g, %g", static_cast<float>(i), std::pow(i, 1.45123), i * 0.5, UnsignedAsFloat(i).as_float);
+		uint64_t bits = randomness();
+		double value;
+		std::memcpy(&value, &bits, sizeof(value));
+		result.push_back(value);
+		// short decimals that end exactly on ties after rounding
+		result.push_back(static_cast<double>(static_cast<int>(bits)) * 1e-3);
+		result.push_back(static_cast<double>(static_cast<int>(bits) % 100000) + 0.5);
+		uint64_t denormal_bits = bits & 0x800fffffffffffffllu;
+		std::memcpy(&value, &denormal_bits, sizeof(value));
+		result.push_back(value);
 	}
+	return result;
 }
-TEST(format_float, DISABLED_format_float_performance)
+TEST(format_float, precision_matches_printf)
 {
-	for (unsigned i = 0; i < num_iterations; ++i)
+	for (double value : random_doubles(10000))
 	{
-		fmt::stack_format<1024>("%0, %1, %2, %3", static_cast<float>(i), std::pow(i, 1.45123), i * 0.5, UnsignedAsFloat(i).as_float);
+		if (std::isnan(value)) continue;
+		for (int precision = 1; precision <= 17; ++precision)
+		{
+			char buffer[64];
+			snprintf(buffer, sizeof(buffer) / sizeof(*buffer), "%.*g", precision, value);
+			ASSERT_EQ(buffer, fmt::stack_print<1024>(fmt::precise_float(value, precision)));
+		}
 	}
 }
+TEST(format_float, pad_float_matches_slow_path)
+{
+	for (double value : random_doubles(10000))
+	{
+		if (!std::isfinite(value) || value <= 0.0) continue;
+		for (int num_digits = 5; num_digits <= 17; ++num_digits)
+		{
+			fmt::stack_format_func<1024> slow([&](fmt::format_it<char, fmt::detail::stack_format_it<char, std::allocator<char> > > it)
+			{
+				return fmt::detail::fixed_width_dtoa_slow(it, value, num_digits);
+			});
+			ASSERT_EQ(slow.c_str(), fmt::stack_print<1024>(fmt::pad_float(value, num_digits)));
+		}
+	}
 }
-#include <thread>
-namespace
+
+template<typename T>
+::testing::AssertionResult TestFitsInMaxFormattedSize(const T & value)
 {
-TEST(format_float, DISABLED_test_all_floats)
+	fmt::stack_print<1024> formatted(value);
+	if (formatted.size() <= fmt::max_formatted_size<T>::value) return ::testing::AssertionSuccess();
+	else return ::testing::AssertionFailure() << formatted.c_str() << " is longer than " << fmt::max_formatted_size<T>::value << " characters";
+}
+template<typename T, size_t... NumDigits>
+::testing::AssertionResult TestPadFitsInMaxFormattedSize(T value, std::index_sequence<NumDigits...>)
 {
-	std::vector<std::thread> threads;
-	constexpr unsigned start = 0;
-	constexpr int num_threads = 4;
-	constexpr int step = num_threads;// * 1024;
-	for (unsigned i = 0; i < num_threads; ++i)
+	::testing::AssertionResult results[] = { TestFitsInMaxFormattedSize(fmt::pad_float<int(NumDigits) + 1>(value))... };
+	for (const ::testing::AssertionResult & result : results)
 	{
-		threads.emplace_back([i]
+		if (!result) return result;
+	}
+	return ::testing::AssertionSuccess();
+}
+// the numbers that are most likely to be long: the ones that round up to the
+// next power of ten at every precision, their neighbors, and denormals
+template<typename T>
+std::vector<T> rounding_boundaries(int min_exponent, int max_exponent, int max_digits)
+{
+	std::vector<T> result;
+	char buffer[64];
+	for (int exponent = min_exponent; exponent <= max_exponent; ++exponent)
+	{
+		for (int digits = 0; digits <= max_digits; ++digits)
 		{
-			for (unsigned j = i + start;;)
+			snprintf(buffer, sizeof(buffer), "9.%s5e%d", std::string(digits, '9').c_str(), exponent);
+			T value = static_cast<T>(strtod(buffer, nullptr));
+			for (T boundary : { value, std::nextafter(value, T(0)), std::nextafter(value, std::numeric_limits<T>::infinity()) })
 			{
-				ASSERT_TRUE(TestDoublePrinting(UnsignedAsFloat(j).as_float));
-				j += step;
-				if (!(j % 0x100000))
-				{
-					std::cout << fmt::stack_format<1024>("0x%0, %1%%", fmt::hex(j), j / 42949672.96) << std::endl;
-				}
-				if (j == i) break;
+				result.push_back(boundary);
+				result.push_back(-boundary);
 			}
-		});
+		}
+	}
+	std::mt19937_64 random(7);
+	for (int i = 0; i < 1000; ++i)
+	{
+		T denormal = std::numeric_limits<T>::denorm_min() * static_cast<T>(random() % (uint64_t(1) << (std::numeric_limits<T>::digits - 1)));
+		result.push_back(denormal);
+		result.push_back(-denormal);
+	}
+	for (T special : { std::numeric_limits<T>::max(), std::numeric_limits<T>::min(), std::numeric_limits<T>::denorm_min(), std::numeric_limits<T>::infinity(), std::numeric_limits<T>::quiet_NaN(), T(0) })
+	{
+		result.push_back(special);
+		result.push_back(-special);
+	}
+	return result;
+}
+TEST(format_float, max_formatted_size)
+{
+	for (double value : rounding_boundaries<double>(-324, 308, 17))
+	{
+		ASSERT_TRUE(TestFitsInMaxFormattedSize(value));
+		ASSERT_TRUE(TestFitsInMaxFormattedSize(fmt::nodrift_float(value)));
+		ASSERT_TRUE(TestFitsInMaxFormattedSize(fmt::float_as_fixed(value)));
+		ASSERT_TRUE(TestPadFitsInMaxFormattedSize(value, std::make_index_sequence<20>()));
+	}
+	for (float value : rounding_boundaries<float>(-46, 38, 9))
+	{
+		ASSERT_TRUE(TestFitsInMaxFormattedSize(value));
+		ASSERT_TRUE(TestFitsInMaxFormattedSize(fmt::nodrift_float(value)));
+		ASSERT_TRUE(TestFitsInMaxFormattedSize(fmt::float_as_fixed(value)));
+		ASSERT_TRUE(TestPadFitsInMaxFormattedSize(value, std::make_index_sequence<20>()));
+	}
+	ASSERT_EQ("1.0e+100", fmt::stack_print_auto(fmt::pad_float<7>(9.9996942179524442e+99)));
+	ASSERT_EQ("1.00e+100", fmt::stack_print_auto(fmt::pad_float<8>(9.9996942179524442e+99)));
+}
+
+struct UnsignedAsFloat
+{
+	UnsignedAsFloat(unsigned value)
+		: as_unsigned(value)
+	{
+	}
+
+	union
+	{
+		float as_float;
+		unsigned as_unsigned;
+	};
+};
+
+TEST(format_float, sampled_floats)
+{
+	for (uint64_t i = 0; i < 0x100000000llu; i += 9973)
+	{
+		ASSERT_TRUE(TestFloatPrinting(UnsignedAsFloat(unsigned(i)).as_float));
 	}
-	for (std::thread & thread : threads)
+	for (float value : { 0.0f, -0.0f, 1.0f, 0.1f, 3.4028235e38f, 1.1754944e-38f, 1e-45f, 16777216.0f, 1e21f, 1e-7f, 0.5f, 2.5f })
 	{
-		thread.join();
+		ASSERT_TRUE(TestFloatPrinting(value));
 	}
 }
 }
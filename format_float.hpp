@@ -25,10 +25,13 @@ For more information, please refer to <http://unlicense.org/>
 
 #include "format_it.hpp"
 #include "format_integers.hpp"
+#include "shortest_dtoa.hpp"
 #include "double_conversion/fast-dtoa.h"
 #include "double_conversion/double-conversion.h"
 #include "double_conversion/bignum-dtoa.h"
 #include <iterator>
+#include <cmath>
+#include <limits>
 
 namespace fmt
 {
@@ -85,64 +88,121 @@ double_conversion::FastDtoaResult dtoa_into_buffer(char (&buffer)[Size], double
 	}
 	return result;
 }
+// shortest digits that read back as the same value. define
+// FORMAT_SHORTEST_DOUBLE_CONVERSION to use Grisu with the bignum fallback
+// instead of Ryu
+static constexpr int shortest_dtoa_buffer_size = double_conversion::kFastDtoaMaximalLength + 1;
+inline double_conversion::FastDtoaResult shortest_dtoa(char (&buffer)[shortest_dtoa_buffer_size], double value)
+{
+#ifdef FORMAT_SHORTEST_DOUBLE_CONVERSION
+	return dtoa_into_buffer(buffer, value, double_conversion::FAST_DTOA_SHORTEST, double_conversion::BIGNUM_DTOA_SHORTEST, 0);
+#else
+	return ryu_dtoa(value, buffer);
+#endif
+}
+inline double_conversion::FastDtoaResult shortest_dtoa(char (&buffer)[shortest_dtoa_buffer_size], float value)
+{
+#ifdef FORMAT_SHORTEST_DOUBLE_CONVERSION
+	return dtoa_into_buffer(buffer, value, double_conversion::FAST_DTOA_SHORTEST_SINGLE, double_conversion::BIGNUM_DTOA_SHORTEST_SINGLE, 0);
+#else
+	return ryu_dtoa(value, buffer);
+#endif
+}
 
-// this function matches libstdc++ printf("%g", value) for all single precision
-// floating point numbers. I didn't run tests for double precision but the
-// results are probably not too far off
+// prints the digits in [buffer, end) like printf("%g"). end has to be past the
+// last digit that isn't zero
 template<typename C, typename It>
-format_it<C, It> printf_style_dtoa(format_it<C, It> it, double value, int num_digits = 6)
+format_it<C, It> finish_printf_style_dtoa(format_it<C, It> it, const char * buffer, const char * end, int decimal_point, int num_digits)
 {
-	auto start = start_dtoa(it, value);
-	if (start.finished) return start.it;
-	it = start.it;
-	value = start.new_value;
-
-	char buffer[1024];
-	double_conversion::FastDtoaResult result = dtoa_into_buffer(buffer, value, double_conversion::FAST_DTOA_PRECISION, double_conversion::BIGNUM_DTOA_PRECISION, num_digits);
-	char * last_non_zero = std::find_if(std::reverse_iterator<char *>(buffer + result.length), std::reverse_iterator<char *>(buffer), [](char c){ return c != '0'; }).base();
 	auto start_scientific = [&]
 	{
 		*it++ = buffer[0];
-		--result.decimal_point;
-		if (last_non_zero != buffer + 1)
+		--decimal_point;
+		if (end != buffer + 1)
 		{
 			*it++ = '.';
-			it = std::copy(buffer + 1, last_non_zero, it);
+			it = write_chars(it, buffer + 1, end);
 		}
 		*it++ = 'e';
 	};
-	if (result.decimal_point < -3)
+	if (decimal_point < -3)
 	{
 		start_scientific();
-		if (result.decimal_point > -10) return it.printpacked("-0", -result.decimal_point);
-		else return it.print(result.decimal_point);
+		if (decimal_point > -10) return it.printpacked("-0", -decimal_point);
+		else return it.print(decimal_point);
 	}
-	else if (result.decimal_point > num_digits)
+	else if (decimal_point > num_digits)
 	{
 		start_scientific();
-		if (result.decimal_point < 10) return it.printpacked("+0", result.decimal_point);
-		else return it.printpacked('+', result.decimal_point);
+		if (decimal_point < 10) return it.printpacked("+0", decimal_point);
+		else return it.printpacked('+', decimal_point);
 	}
-	else if (result.decimal_point < 1)
+	else if (decimal_point < 1)
 	{
 		*it++ = "0.";
-		it = std::fill_n(it, 0 - result.decimal_point, '0');
-		return std::copy(buffer, last_non_zero, it);
+		it = std::fill_n(it, 0 - decimal_point, '0');
+		return write_chars(it, buffer, end);
 	}
 	else
 	{
-		char * decimal = buffer + result.decimal_point;
-		char * mid = std::min(decimal, last_non_zero);
-		it = std::copy(buffer, mid, it);
-		if (mid != last_non_zero)
+		const char * decimal = buffer + decimal_point;
+		const char * mid = std::min(decimal, end);
+		it = write_chars(it, buffer, mid);
+		if (mid != end)
 		{
 			*it++ = '.';
-			return it = std::copy(mid, last_non_zero, it);
+			return it = write_chars(it, mid, end);
 		}
-		else if (mid != decimal) return std::copy(mid, decimal, it);
-		else return it;
+		else return std::fill_n(it, decimal - mid, '0');
 	}
 }
+// for large precisions and for exact ties
+template<typename C, typename It>
+format_it<C, It> printf_style_dtoa_slow(format_it<C, It> it, double value, int num_digits)
+{
+	char buffer[1024];
+	double_conversion::FastDtoaResult result = dtoa_into_buffer(buffer, value, double_conversion::FAST_DTOA_PRECISION, double_conversion::BIGNUM_DTOA_PRECISION, num_digits);
+	char * last_non_zero = std::find_if(std::reverse_iterator<char *>(buffer + result.length), std::reverse_iterator<char *>(buffer), [](char c){ return c != '0'; }).base();
+	return finish_printf_style_dtoa(it, buffer, last_non_zero, result.decimal_point, num_digits);
+}
+template<typename C, typename It>
+format_it<C, It> printf_style_dtoa(format_it<C, It> it, double value, int num_digits = 6);
+// the float engine only handles a few digits. the double engine can do more
+template<typename C, typename It>
+format_it<C, It> printf_style_dtoa_slow(format_it<C, It> it, float value, int num_digits)
+{
+	return printf_style_dtoa(it, static_cast<double>(value), num_digits);
+}
+// this function matches libstdc++ printf("%g", value) for all single precision
+// floating point numbers. I didn't run tests for double precision but the
+// results are probably not too far off
+template<typename C, typename It, typename T>
+format_it<C, It> printf_style_dtoa_ryu(format_it<C, It> it, T value, int num_digits)
+{
+	auto start = start_dtoa(it, value);
+	if (start.finished) return start.it;
+
+	char buffer[shortest_dtoa_buffer_size];
+	double_conversion::FastDtoaResult result;
+	if (!ryu_precision_dtoa(start.new_value, num_digits, buffer, result)) return printf_style_dtoa_slow(start.it, start.new_value, num_digits);
+	return finish_printf_style_dtoa(start.it, buffer, buffer + result.length, result.decimal_point, num_digits);
+}
+template<typename C, typename It>
+format_it<C, It> printf_style_dtoa(format_it<C, It> it, double value, int num_digits)
+{
+	return printf_style_dtoa_ryu(it, value, num_digits);
+}
+template<typename C, typename It>
+format_it<C, It> printf_style_dtoa(format_it<C, It> it, float value, int num_digits = 6)
+{
+	return printf_style_dtoa_ryu(it, value, num_digits);
+}
+// integers print like doubles
+template<typename C, typename It, typename T>
+format_it<C, It> printf_style_dtoa(format_it<C, It> it, T value, int num_digits = 6)
+{
+	return printf_style_dtoa_ryu(it, static_cast<double>(value), num_digits);
+}
 template<typename C, typename It>
 format_it<C, It> finish_fixed_dtoa(format_it<C, It> it, char * buffer, double_conversion::FastDtoaResult result)
 {
@@ -151,20 +211,20 @@ format_it<C, It> finish_fixed_dtoa(format_it<C, It> it, char * buffer, double_co
 	{
 		*it++ = "0.";
 		it = std::fill_n(it, 0 - result.decimal_point, '0');
-		return std::copy(buffer, end, it);
+		return write_chars(it, buffer, end);
 	}
 	else
 	{
 		char * decimal = buffer + result.decimal_point;
 		if (decimal < end)
 		{
-			it = std::copy(buffer, decimal, it);
+			it = write_chars(it, buffer, decimal);
 			*it++ = '.';
-			return it = std::copy(decimal, end, it);
+			return it = write_chars(it, decimal, end);
 		}
 		else
 		{
-			it = std::copy(buffer, end, it);
+			it = write_chars(it, buffer, end);
 			return std::fill_n(it, decimal - end, '0');
 		}
 	}
@@ -175,8 +235,8 @@ format_it<C, It> fixed_dtoa(format_it<C, It> it, double value)
 	auto start = start_dtoa(it, value);
 	if (start.finished) return start.it;
 
-	char buffer[1024];
-	return finish_fixed_dtoa(start.it, buffer, dtoa_into_buffer(buffer, start.new_value, double_conversion::FAST_DTOA_SHORTEST, double_conversion::BIGNUM_DTOA_SHORTEST, 0));
+	char buffer[shortest_dtoa_buffer_size];
+	return finish_fixed_dtoa(start.it, buffer, shortest_dtoa(buffer, start.new_value));
 }
 template<typename C, typename It>
 format_it<C, It> fixed_dtoa(format_it<C, It> it, float value)
@@ -184,8 +244,8 @@ format_it<C, It> fixed_dtoa(format_it<C, It> it, float value)
 	auto start = start_dtoa(it, value);
 	if (start.finished) return start.it;
 
-	char buffer[1024];
-	return finish_fixed_dtoa(start.it, buffer, dtoa_into_buffer(buffer, start.new_value, double_conversion::FAST_DTOA_SHORTEST_SINGLE, double_conversion::BIGNUM_DTOA_SHORTEST_SINGLE, 0));
+	char buffer[shortest_dtoa_buffer_size];
+	return finish_fixed_dtoa(start.it, buffer, shortest_dtoa(buffer, start.new_value));
 }
 inline char round_char_to_even(char c, char next, bool has_more)
 {
@@ -227,21 +287,12 @@ inline bool round_buffer(char * begin, char * print_end, char * end)
 	std::fill(rounded_end, print_end, '0');
 	return overflowed;
 }
+// prints the num_digits digits in buffer so that they take num_digits
+// characters. this rounds in the buffer to make room for the decimal point and
+// the exponent
 template<typename C, typename It>
-format_it<C, It> fixed_width_dtoa(format_it<C, It> it, double value, int num_digits)
+format_it<C, It> finish_fixed_width_dtoa(format_it<C, It> it, char * buffer, double_conversion::FastDtoaResult result, int num_digits)
 {
-	if (FloatSplit(value).negative)
-	{
-		*it++ = '-';
-		value = -value;
-		--num_digits;
-	}
-	if (std::isnan(value)) return std::fill_n(it.print("nan"), std::max(0, num_digits - 3), ' ');
-	else if (value == 0.0) return std::fill_n(it.print("0."), num_digits - 2, '0');
-	else if (value == std::numeric_limits<double>::infinity()) return std::fill_n(it.print("inf"), std::max(0, num_digits - 3), ' ');
-
-	char buffer[1024];
-	double_conversion::FastDtoaResult result = dtoa_into_buffer(buffer, value, double_conversion::FAST_DTOA_PRECISION, double_conversion::BIGNUM_DTOA_PRECISION, num_digits);
 	auto start_scientific = [&]
 	{
 		--result.decimal_point;
@@ -256,7 +307,7 @@ format_it<C, It> fixed_width_dtoa(format_it<C, It> it, double value, int num_dig
 			}
 			*it++ = buffer[0];
 			*it++ = '.';
-			it = std::copy(buffer + 1, print_end, it);
+			it = write_chars(it, buffer + 1, print_end);
 		}
 		else *it++ = buffer[0];
 		*it++ = 'e';
@@ -286,7 +337,7 @@ format_it<C, It> fixed_width_dtoa(format_it<C, It> it, double value, int num_dig
 		{
 			*it++ = "0.";
 			it = std::fill_n(it, 0 - result.decimal_point, '0');
-			return std::copy(buffer, print_end, it);
+			return write_chars(it, buffer, print_end);
 		}
 	}
 	else if (result.decimal_point < num_digits)
@@ -294,27 +345,106 @@ format_it<C, It> fixed_width_dtoa(format_it<C, It> it, double value, int num_dig
 		char * print_end = buffer + num_digits - 1;
 		round_buffer(buffer, print_end, print_end + 1);
 		char * decimal = buffer + result.decimal_point;
-		it = std::copy(buffer, decimal, it);
+		it = write_chars(it, buffer, decimal);
 		*it++ = '.';
-		return it = std::copy(decimal, print_end, it);
+		return it = write_chars(it, decimal, print_end);
 	}
-	else return std::copy(buffer, buffer + num_digits, it);
+	else return write_chars(it, buffer, buffer + num_digits);
 }
+// for large widths and for exact ties
 template<typename C, typename It>
-format_it<C, It> ecma_style_dtoa(format_it<C, It> it, double value)
+format_it<C, It> fixed_width_dtoa_slow(format_it<C, It> it, double value, int num_digits)
 {
 	char buffer[1024];
-	double_conversion::StringBuilder builder(buffer, sizeof(buffer) / sizeof(*buffer));
-	double_conversion::DoubleToStringConverter::EcmaScriptConverter().ToShortest(value, builder);
-	return std::copy(buffer, buffer + builder.position(), it);
+	return finish_fixed_width_dtoa(it, buffer, dtoa_into_buffer(buffer, value, double_conversion::FAST_DTOA_PRECISION, double_conversion::BIGNUM_DTOA_PRECISION, num_digits), num_digits);
+}
+template<typename C, typename It, typename T>
+format_it<C, It> fixed_width_dtoa_ryu(format_it<C, It> it, T value, int num_digits);
+template<typename C, typename It>
+format_it<C, It> fixed_width_dtoa_slow(format_it<C, It> it, float value, int num_digits)
+{
+	return fixed_width_dtoa_ryu(it, static_cast<double>(value), num_digits);
+}
+template<typename C, typename It, typename T>
+format_it<C, It> fixed_width_dtoa_ryu(format_it<C, It> it, T value, int num_digits)
+{
+	if (FloatSplit(value).negative)
+	{
+		*it++ = '-';
+		value = -value;
+		--num_digits;
+	}
+	if (std::isnan(value)) return std::fill_n(it.print("nan"), std::max(0, num_digits - 3), ' ');
+	else if (value == 0.0) return std::fill_n(it.print("0."), num_digits - 2, '0');
+	else if (value == std::numeric_limits<double>::infinity()) return std::fill_n(it.print("inf"), std::max(0, num_digits - 3), ' ');
+
+	char buffer[shortest_dtoa_buffer_size];
+	double_conversion::FastDtoaResult result;
+	if (!ryu_precision_dtoa(value, num_digits, buffer, result)) return fixed_width_dtoa_slow(it, value, num_digits);
+	// the layout below wants all num_digits digits
+	std::fill(buffer + result.length, buffer + num_digits, '0');
+	result.length = num_digits;
+	return finish_fixed_width_dtoa(it, buffer, result, num_digits);
+}
+// same output as double_conversion's EcmaScriptConverter
+template<typename C, typename It>
+format_it<C, It> finish_ecma_dtoa(format_it<C, It> it, char * buffer, double_conversion::FastDtoaResult result)
+{
+	int exponent = result.decimal_point - 1;
+	if (exponent >= -6 && exponent < 21) return finish_fixed_dtoa(it, buffer, result);
+	*it++ = buffer[0];
+	if (result.length != 1)
+	{
+		*it++ = '.';
+		it = write_chars(it, buffer + 1, buffer + result.length);
+	}
+	if (exponent < 0) return it.printpacked("e-", -exponent);
+	else return it.printpacked("e+", exponent);
+}
+template<typename C, typename It>
+format_it<C, It> fixed_width_dtoa(format_it<C, It> it, double value, int num_digits)
+{
+	return fixed_width_dtoa_ryu(it, value, num_digits);
+}
+template<typename C, typename It>
+format_it<C, It> fixed_width_dtoa(format_it<C, It> it, float value, int num_digits)
+{
+	return fixed_width_dtoa_ryu(it, value, num_digits);
+}
+template<typename C, typename It, typename T>
+format_it<C, It> fixed_width_dtoa(format_it<C, It> it, T value, int num_digits)
+{
+	return fixed_width_dtoa_ryu(it, static_cast<double>(value), num_digits);
+}
+template<typename C, typename It, typename T>
+format_it<C, It> ecma_style_dtoa_ryu(format_it<C, It> it, T value)
+{
+	if (std::isnan(value)) return it.print("NaN");
+	if (FloatSplit(value).negative)
+	{
+		if (value == 0.0) return it.print('0');
+		*it++ = '-';
+		value = -value;
+	}
+	if (value == 0.0) return it.print('0');
+	else if (value == std::numeric_limits<T>::infinity()) return it.print("Infinity");
+	char buffer[shortest_dtoa_buffer_size];
+	return finish_ecma_dtoa(it, buffer, shortest_dtoa(buffer, value));
+}
+template<typename C, typename It>
+format_it<C, It> ecma_style_dtoa(format_it<C, It> it, double value)
+{
+	return ecma_style_dtoa_ryu(it, value);
 }
 template<typename C, typename It>
 format_it<C, It> ecma_style_dtoa(format_it<C, It> it, float value)
 {
-	char buffer[1024];
-	double_conversion::StringBuilder builder(buffer, sizeof(buffer) / sizeof(*buffer));
-	double_conversion::DoubleToStringConverter::EcmaScriptConverter().ToShortestSingle(value, builder);
-	return std::copy(buffer, buffer + builder.position(), it);
+	return ecma_style_dtoa_ryu(it, value);
+}
+template<typename C, typename It, typename T>
+format_it<C, It> ecma_style_dtoa(format_it<C, It> it, T value)
+{
+	return ecma_style_dtoa_ryu(it, static_cast<double>(value));
 }
 }
 template<typename C, typename It>
@@ -327,6 +457,15 @@ format_it<C, It> format(format_it<C, It> it, double value)
 {
 	return detail::printf_style_dtoa(it, value);
 }
+// "-1.79769e+308"
+template<>
+struct max_formatted_size<float> : std::integral_constant<size_t, 13>
+{
+};
+template<>
+struct max_formatted_size<double> : std::integral_constant<size_t, 13>
+{
+};
 template<typename T>
 struct nodrift_float_formatter
 {
@@ -342,6 +481,16 @@ format_it<C, It> format(format_it<C, It> it, nodrift_float_formatter<T> value)
 {
 	return detail::ecma_style_dtoa(it, value.value);
 }
+// "-0.0000012345678901234567"
+template<>
+struct max_formatted_size<nodrift_float_formatter<double> > : std::integral_constant<size_t, 25>
+{
+};
+// numbers below 1e21 are printed without exponent: "-123456790000000000000"
+template<>
+struct max_formatted_size<nodrift_float_formatter<float> > : std::integral_constant<size_t, 22>
+{
+};
 template<typename T>
 struct precise_float_formatter
 {
@@ -374,6 +523,30 @@ format_it<C, It> format(format_it<C, It> it, pad_float_formatter<T> value)
 {
 	return detail::fixed_width_dtoa(it, value.value, value.num_digits);
 }
+// same as above but with the number of digits known at compile time
+template<int NumDigits, typename T>
+struct static_pad_float_formatter
+{
+	T value;
+};
+template<int NumDigits, typename T>
+static_pad_float_formatter<NumDigits, T> pad_float(T value)
+{
+	return { value };
+}
+template<typename C, typename It, int NumDigits, typename T>
+format_it<C, It> format(format_it<C, It> it, static_pad_float_formatter<NumDigits, T> value)
+{
+	return detail::fixed_width_dtoa(it, value.value, NumDigits);
+}
+// if there isn't enough space the output is for example "-1e+100". with
+// enough space the output can still be one longer than NumDigits when
+// rounding carries into a three digit exponent: pad_float<7>(9.9999e+99)
+// is "1.0e+100"
+template<int NumDigits, typename T>
+struct max_formatted_size<static_pad_float_formatter<NumDigits, T> > : std::integral_constant<size_t, (NumDigits > 6 ? NumDigits + 1 : 7)>
+{
+};
 template<typename T>
 struct fixed_float_formatter
 {
@@ -389,4 +562,15 @@ format_it<C, It> format(format_it<C, It> it, fixed_float_formatter<T> value)
 {
 	return detail::fixed_dtoa(it, value.value);
 }
+// the smallest numbers have a lot of zeros after the decimal point:
+// "-0." followed by 323 zeros followed by 17 digits
+template<>
+struct max_formatted_size<fixed_float_formatter<double> > : std::integral_constant<size_t, 343>
+{
+};
+// "-0." followed by 44 zeros followed by 9 digits
+template<>
+struct max_formatted_size<fixed_float_formatter<float> > : std::integral_constant<size_t, 56>
+{
+};
 }
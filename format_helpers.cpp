@@ -25,6 +25,9 @@ For more information, please refer to <http://unlicense.org/>
 
 #ifndef DISABLE_GTEST
 #include <gtest/gtest.h>
+#include "string_format.hpp"
+#include <random>
+#include <vector>
 namespace
 {
 TEST(format_helpers, padding)
@@ -53,6 +56,50 @@ TEST(format_helpers, separator)
 	fmt::stack_print<1024> print(fmt::with_separator(a, ", "));
 	ASSERT_EQ("1, 2, 3, 4, 5", print);
 }
+template<typename T>
+::testing::AssertionResult TestArrayMatchesSeparator(const std::vector<T> & values, const char * separator)
+{
+	std::string with_separator = fmt::string_print(fmt::with_separator(values, separator));
+	std::string array = fmt::string_print(fmt::format_array(values, separator));
+	if (with_separator == array) return ::testing::AssertionSuccess();
+	else return ::testing::AssertionFailure() << "format_array printed " << array << " instead of " << with_separator;
+}
+TEST(format_helpers, format_array)
+{
+	std::mt19937_64 randomness(5);
+	std::vector<int> ints;
+	std::vector<short> shorts;
+	std::vector<long long> longs;
+	std::vector<unsigned long long> ulongs;
+	std::vector<double> doubles;
+	std::vector<float> floats;
+	for (int i = 0; i < 1000; ++i)
+	{
+		uint64_t bits = randomness() >> (randomness() % 64);
+		ints.push_back(int(bits));
+		shorts.push_back(short(bits));
+		longs.push_back((long long)bits);
+		ulongs.push_back(bits);
+		doubles.push_back(double((long long)bits) / 1024);
+		floats.push_back(float((long long)bits) / 3);
+	}
+	ints.push_back(std::numeric_limits<int>::min());
+	longs.push_back(std::numeric_limits<long long>::min());
+	shorts.push_back(std::numeric_limits<short>::min());
+	doubles.push_back(-std::numeric_limits<double>::max());
+	for (const char * separator : { ", ", "", "\n", "a separator that is too long for blocks" })
+	{
+		ASSERT_TRUE(TestArrayMatchesSeparator(ints, separator));
+		ASSERT_TRUE(TestArrayMatchesSeparator(shorts, separator));
+		ASSERT_TRUE(TestArrayMatchesSeparator(longs, separator));
+		ASSERT_TRUE(TestArrayMatchesSeparator(ulongs, separator));
+		ASSERT_TRUE(TestArrayMatchesSeparator(doubles, separator));
+		ASSERT_TRUE(TestArrayMatchesSeparator(floats, separator));
+	}
+	ASSERT_TRUE(TestArrayMatchesSeparator(std::vector<int>(), ", "));
+	ASSERT_TRUE(TestArrayMatchesSeparator(std::vector<std::string>{ "a", "b" }, ", "));
+	ASSERT_EQ("", fmt::stack_print<64>(fmt::format_array(ints.data(), 0, ", ")));
+}
 TEST(format_helpers, separator_it)
 {
 	std::vector<int> a = { 1, 2, 3, 4, 5 };
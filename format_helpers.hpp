@@ -58,6 +58,115 @@ format_it<C, It> format(format_it<C, It> it, separated_formatter<C, BeginIt, End
 	}
 	return it;
 }
+template<typename T, typename C>
+struct array_formatter
+{
+	const T * begin;
+	const T * end;
+	const C * separator;
+};
+// same output as with_separator, but numbers are converted a block at a time
+// and each block goes to the output in one write
+template<typename T, typename C>
+array_formatter<T, C> format_array(const T * data, size_t size, const C * separator)
+{
+	return { data, data + size, separator };
+}
+template<typename Container, typename C>
+auto format_array(const Container & container, const C * separator) -> array_formatter<typename std::remove_const<typename std::remove_pointer<decltype(container.data())>::type>::type, C>
+{
+	return { container.data(), container.data() + container.size(), separator };
+}
+namespace detail
+{
+// types for which format_array uses blocks. other types print one at a time
+template<typename T, typename C>
+struct is_batch_formattable : std::false_type
+{
+};
+template<> struct is_batch_formattable<short, char> : std::true_type {};
+template<> struct is_batch_formattable<unsigned short, char> : std::true_type {};
+template<> struct is_batch_formattable<int, char> : std::true_type {};
+template<> struct is_batch_formattable<unsigned, char> : std::true_type {};
+template<> struct is_batch_formattable<long, char> : std::true_type {};
+template<> struct is_batch_formattable<unsigned long, char> : std::true_type {};
+template<> struct is_batch_formattable<long long, char> : std::true_type {};
+template<> struct is_batch_formattable<unsigned long long, char> : std::true_type {};
+template<> struct is_batch_formattable<float, char> : std::true_type {};
+template<> struct is_batch_formattable<double, char> : std::true_type {};
+
+static constexpr size_t array_block_size = 64;
+static constexpr size_t max_array_separator_size = 16;
+template<typename T>
+struct array_block_buffer
+{
+	char data[array_block_size * (max_formatted_size<T>::value + max_array_separator_size)];
+};
+
+// digit counts first, then the offsets of all numbers in the block, then the
+// digits. that way the conversions don't depend on each other
+template<typename T>
+char * format_array_block(const T * begin, const T * end, const char * separator, size_t separator_size, bool first, char * out, std::true_type /*is_integral*/)
+{
+	typedef typename std::make_unsigned<T>::type U;
+	U magnitudes[array_block_size];
+	size_t offsets[array_block_size];
+	size_t count = end - begin;
+	size_t offset = first ? 0 : separator_size;
+	for (size_t i = 0; i < count; ++i)
+	{
+		bool negative = begin[i] < 0;
+		magnitudes[i] = negative ? U(0) - U(begin[i]) : U(begin[i]);
+		offsets[i] = offset;
+		offset += digits10(magnitudes[i]) + negative + separator_size;
+	}
+	for (size_t i = 0; i < count; ++i)
+	{
+		char * number = out + offsets[i];
+		if (i || !first) std::memcpy(number - separator_size, separator, separator_size);
+		if (begin[i] < 0) *number++ = '-';
+		itoa_base10(magnitudes[i], number);
+	}
+	return out + offset - separator_size;
+}
+template<typename T>
+char * format_array_block(const T * begin, const T * end, const char * separator, size_t separator_size, bool first, char * out, std::false_type /*is_integral*/)
+{
+	format_it<char, unchecked_format_it<char> > it{ unchecked_format_it<char>(out) };
+	for (const T * element = begin; element != end; ++element)
+	{
+		if (element != begin || !first) it.write(separator, separator + separator_size);
+		it = adl_format(it, *element);
+	}
+	return it.it().buffer;
+}
+template<typename C, typename It, typename T>
+format_it<C, It> format_array_blocks(format_it<C, It> it, array_formatter<T, C> array, std::false_type)
+{
+	return it.print(with_separator(array.begin, array.end, array.separator));
+}
+template<typename C, typename It, typename T>
+format_it<C, It> format_array_blocks(format_it<C, It> it, array_formatter<T, C> array, std::true_type)
+{
+	size_t separator_size = std::char_traits<C>::length(array.separator);
+	if (separator_size > max_array_separator_size) return format_array_blocks(it, array, std::false_type());
+	array_block_buffer<T> buffer;
+	for (const T * block = array.begin; block != array.end;)
+	{
+		const T * block_end = block + std::min(size_t(array.end - block), array_block_size);
+		char * end = format_array_block(block, block_end, array.separator, separator_size, block == array.begin, buffer.data, std::is_integral<T>());
+		it.write(buffer.data, end);
+		block = block_end;
+	}
+	return it;
+}
+}
+template<typename C, typename It, typename T>
+format_it<C, It> format(format_it<C, It> it, array_formatter<T, C> array)
+{
+	return detail::format_array_blocks(it, array, detail::is_batch_formattable<T, C>());
+}
+
 namespace detail
 {
 template<typename C, typename It, typename T>
@@ -129,7 +238,7 @@ format_it<C, It> format(format_it<C, It> it, const left_padded_formatter<V, C> &
 {
 	stack_print<1024> print_value(padding.value);
 	it = std::fill_n(it, std::max(0, padding.num_padding - int(print_value.end() - print_value.begin())), padding.padding);
-	return std::copy(print_value.begin(), print_value.end(), it);
+	return detail::write_chars(it, print_value.begin(), print_value.end());
 }
 template<typename V, typename C>
 struct right_padded_formatter : detail::padded_formatter<V, C>
@@ -148,7 +257,7 @@ format_it<C, It> format(format_it<C, It> it, const right_padded_formatter<V, C>
 	// but it is needed for padding on the left, and I think they should be similar
 	// in terms of both code and performance
 	stack_print<1024> print_value(padding.value);
-	it = std::copy(print_value.begin(), print_value.end(), it);
+	it = detail::write_chars(it, print_value.begin(), print_value.end());
 	return std::fill_n(it, std::max(0, padding.num_padding - int(print_value.end() - print_value.begin())), padding.padding);
 }
 template<typename V, typename C>
@@ -168,7 +277,7 @@ format_it<C, It> format(format_it<C, It> it, const both_padded_formatter<V, C> &
 	int to_pad = std::max(0, padding.num_padding - int(print_value.end() - print_value.begin()));
 	int right_half = to_pad / 2;
 	it = std::fill_n(it, to_pad - right_half, padding.padding);
-	it = std::copy(print_value.begin(), print_value.end(), it);
+	it = detail::write_chars(it, print_value.begin(), print_value.end());
 	return std::fill_n(it, right_half, padding.padding);
 }
 template<typename V, typename C>
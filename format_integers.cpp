@@ -26,6 +26,9 @@ For more information, please refer to <http://unlicense.org/>
 #ifndef DISABLE_GTEST
 #include <gtest/gtest.h>
 #include "stack_format.hpp"
+#include <random>
+#include <cstdio>
+#include <vector>
 namespace
 {
 TEST(format_int, boolalpha)
@@ -51,6 +54,61 @@ TEST(format_int, integers)
 	fmt::stack_print<1024> all(-1, 22, -333, 4444, -55555, 666666, -7777777, 88888888, -999999999, 1010101010, -11111111111ll, 121212121212llu, -1313131313131ll, 14141414141414llu, -151515151515151ll, 1616161616161616llu, -17171717171717171ll, 181818181818181818llu, -1919191919191919191ll, 12020202020202020202llu);
 	ASSERT_EQ(std::string("-1 22 -333 4444 -55555 666666 -7777777 88888888 -999999999 1010101010 -11111111111 121212121212 -1313131313131 14141414141414 -151515151515151 1616161616161616 -17171717171717171 181818181818181818 -1919191919191919191 12020202020202020202"), all.c_str());
 }
+template<typename T>
+::testing::AssertionResult TestMatchesToString(T value)
+{
+	char buffer[20];
+	std::string formatted(buffer, fmt::detail::itoa_base10(value, buffer));
+	if (formatted == std::to_string(value)) return ::testing::AssertionSuccess();
+	else return ::testing::AssertionFailure() << value << " was printed as " << formatted;
+}
+TEST(format_int, all_lengths)
+{
+	std::mt19937_64 randomness(5);
+	for (int i = 0; i < 10000; ++i)
+	{
+		uint64_t value = randomness() >> (randomness() % 64);
+		ASSERT_TRUE(TestMatchesToString(static_cast<unsigned long long>(value)));
+		ASSERT_TRUE(TestMatchesToString(static_cast<unsigned long>(value)));
+		ASSERT_TRUE(TestMatchesToString(static_cast<uint32_t>(value)));
+		ASSERT_TRUE(TestMatchesToString(static_cast<uint16_t>(value)));
+	}
+	for (unsigned long long power = 1; power < 10000000000000000000llu; power *= 10)
+	{
+		ASSERT_TRUE(TestMatchesToString(power - 1));
+		ASSERT_TRUE(TestMatchesToString(power));
+		ASSERT_TRUE(TestMatchesToString(static_cast<uint32_t>(power - 1)));
+		ASSERT_TRUE(TestMatchesToString(static_cast<uint32_t>(power)));
+	}
+	ASSERT_TRUE(TestMatchesToString(std::numeric_limits<unsigned long long>::max()));
+	ASSERT_TRUE(TestMatchesToString(std::numeric_limits<uint32_t>::max()));
+}
+TEST(format_int, digit_counts)
+{
+	static_assert(fmt::detail::digits10(0u) == 1, "zero has one digit");
+	static_assert(fmt::detail::digits10(18446744073709551615llu) == 20, "digit counts are constexpr");
+	for (int bit = 0; bit < 64; ++bit)
+	{
+		for (unsigned long long value : { (1llu << bit) - 1, 1llu << bit, (1llu << bit) + 1 })
+		{
+			ASSERT_EQ(std::to_string(value).size(), size_t(fmt::detail::digits10(value)));
+			ASSERT_EQ(fmt::stack_format<64>("%0", fmt::hex(value)).size(), size_t(fmt::detail::digits16(value)));
+			ASSERT_EQ(fmt::stack_format<64>("%0", fmt::oct(value)).size(), size_t(fmt::detail::digits8(value)));
+			ASSERT_EQ(fmt::detail::digits10(value), fmt::detail::digits10(static_cast<unsigned long>(value)));
+			if (bit < 32)
+			{
+				ASSERT_EQ(fmt::detail::digits10(value), fmt::detail::digits10(static_cast<uint32_t>(value)));
+				ASSERT_EQ(fmt::detail::digits16(value), fmt::detail::digits16(static_cast<uint32_t>(value)));
+				ASSERT_EQ(fmt::detail::digits8(value), fmt::detail::digits8(static_cast<uint32_t>(value)));
+			}
+		}
+	}
+	for (unsigned long long power = 10; power < 10000000000000000000llu; power *= 10)
+	{
+		ASSERT_EQ(std::to_string(power - 1).size(), size_t(fmt::detail::digits10(power - 1)));
+		ASSERT_EQ(std::to_string(power).size(), size_t(fmt::detail::digits10(power)));
+	}
+}
 TEST(format_int, hex)
 {
 	fmt::stack_print<1024> hex(fmt::hex(static_cast<unsigned char>(0xfe)), fmt::hex(0x1234567890abcdefllu));
@@ -62,6 +120,69 @@ TEST(format_int, hex)
 	fmt::stack_print<1024> upperhex_single_char(fmt::upperhex(char(5)), fmt::upperhex(char(0xa)), fmt::upperhex(0xb));
 	ASSERT_EQ(std::string("5 A B"), upperhex_single_char.c_str());
 }
+TEST(format_int, hex_fixed)
+{
+	ASSERT_EQ("00000000 0000000000000000 00 0000", fmt::stack_print<1024>(fmt::hex_fixed(0u), fmt::hex_fixed(0llu), fmt::hex_fixed(uint8_t(0)), fmt::hex_fixed(uint16_t(0))));
+	ASSERT_EQ("deadbeef 0123456789abcdef 7f 0a0b", fmt::stack_print<1024>(fmt::hex_fixed(0xdeadbeefu), fmt::hex_fixed(0x0123456789abcdefllu), fmt::hex_fixed(uint8_t(0x7f)), fmt::hex_fixed(uint16_t(0xa0b))));
+	ASSERT_EQ("DEADBEEF 0123456789ABCDEF FF 0A0B", fmt::stack_print<1024>(fmt::upperhex_fixed(0xdeadbeefu), fmt::upperhex_fixed(0x0123456789abcdefllu), fmt::upperhex_fixed(char(-1)), fmt::upperhex_fixed(uint16_t(0xa0b))));
+	ASSERT_EQ("ffffffff ffffffffffffffff", fmt::stack_print<1024>(fmt::hex_fixed(-1), fmt::hex_fixed(-1l)));
+	std::mt19937_64 randomness(5);
+	for (int i = 0; i < 1000; ++i)
+	{
+		unsigned long long value = randomness();
+		char buffer[32];
+		snprintf(buffer, sizeof(buffer), "%016llx %08x", value, unsigned(value));
+		ASSERT_EQ(buffer, fmt::stack_print<1024>(fmt::hex_fixed(value), fmt::hex_fixed(unsigned(value))));
+	}
+}
+TEST(format_int, hex_bytes)
+{
+	std::mt19937 randomness(5);
+	std::vector<unsigned char> bytes(5000);
+	for (unsigned char & byte : bytes) byte = static_cast<unsigned char>(randomness());
+	for (size_t size : { 0, 1, 15, 16, 17, 33, 511, 512, 513, 5000 })
+	{
+		std::string lower;
+		std::string upper;
+		for (size_t i = 0; i < size; ++i)
+		{
+			char buffer[8];
+			snprintf(buffer, sizeof(buffer), "%02x", bytes[i]);
+			lower += buffer;
+			snprintf(buffer, sizeof(buffer), "%02X", bytes[i]);
+			upper += buffer;
+		}
+		ASSERT_EQ(lower, fmt::stack_print<16384>(fmt::hex_bytes(bytes.data(), size)).c_str());
+		ASSERT_EQ(upper, fmt::stack_print<16384>(fmt::upperhex_bytes(bytes.data(), size)).c_str());
+	}
+}
+template<typename T>
+::testing::AssertionResult TestFitsInMaxFormattedSize(const T & value)
+{
+	fmt::stack_print<1024> formatted(value);
+	if (formatted.size() == fmt::max_formatted_size<T>::value) return ::testing::AssertionSuccess();
+	else return ::testing::AssertionFailure() << formatted.c_str() << " doesn't have " << fmt::max_formatted_size<T>::value << " characters";
+}
+TEST(format_int, max_formatted_size)
+{
+	ASSERT_TRUE(TestFitsInMaxFormattedSize(std::numeric_limits<short>::min()));
+	ASSERT_TRUE(TestFitsInMaxFormattedSize(std::numeric_limits<unsigned short>::max()));
+	ASSERT_TRUE(TestFitsInMaxFormattedSize(std::numeric_limits<int>::min()));
+	ASSERT_TRUE(TestFitsInMaxFormattedSize(std::numeric_limits<unsigned>::max()));
+	ASSERT_TRUE(TestFitsInMaxFormattedSize(std::numeric_limits<long>::min()));
+	ASSERT_TRUE(TestFitsInMaxFormattedSize(std::numeric_limits<unsigned long>::max()));
+	ASSERT_TRUE(TestFitsInMaxFormattedSize(std::numeric_limits<long long>::min()));
+	ASSERT_TRUE(TestFitsInMaxFormattedSize(std::numeric_limits<unsigned long long>::max()));
+	ASSERT_TRUE(TestFitsInMaxFormattedSize(fmt::hex(std::numeric_limits<signed char>::min())));
+	ASSERT_TRUE(TestFitsInMaxFormattedSize(fmt::hex(std::numeric_limits<unsigned>::max())));
+	ASSERT_TRUE(TestFitsInMaxFormattedSize(fmt::upperhex(std::numeric_limits<long long>::min())));
+	ASSERT_TRUE(TestFitsInMaxFormattedSize(fmt::upperhex(std::numeric_limits<unsigned long long>::max())));
+	ASSERT_TRUE(TestFitsInMaxFormattedSize(fmt::oct(std::numeric_limits<unsigned char>::max())));
+	ASSERT_TRUE(TestFitsInMaxFormattedSize(fmt::oct(std::numeric_limits<unsigned short>::max())));
+	ASSERT_TRUE(TestFitsInMaxFormattedSize(fmt::oct(std::numeric_limits<unsigned>::max())));
+	ASSERT_TRUE(TestFitsInMaxFormattedSize(fmt::oct(std::numeric_limits<unsigned long long>::max())));
+	ASSERT_TRUE(TestFitsInMaxFormattedSize(fmt::boolalpha(false)));
+}
 TEST(format_int, oct)
 {
 	fmt::stack_print<1024> oct(fmt::oct(static_cast<unsigned char>(0255)), fmt::oct(012345670));
@@ -69,5 +190,52 @@ TEST(format_int, oct)
 	fmt::stack_print<1024> single_oct(fmt::oct(static_cast<char>(5)), fmt::oct(5));
 	ASSERT_EQ(std::string("5 5"), single_oct.c_str());
 }
+#ifdef FORMAT_INT128
+std::string SlowInt128ToString(unsigned __int128 value, unsigned base, const char * digits)
+{
+	std::string result;
+	do
+	{
+		result.insert(result.begin(), digits[value % base]);
+		value /= base;
+	}
+	while (value);
+	return result;
+}
+TEST(format_int, int128)
+{
+	unsigned __int128 max = ~static_cast<unsigned __int128>(0);
+	__int128 min = static_cast<__int128>(max >> 1) * -1 - 1;
+	ASSERT_EQ(std::string("340282366920938463463374607431768211455"), fmt::stack_format<64>("%0", max).c_str());
+	ASSERT_EQ(std::string("-170141183460469231731687303715884105728"), fmt::stack_format<64>("%0", min).c_str());
+	ASSERT_EQ(std::string("-ff ffffffffffffffffffffffffffffffff"), fmt::stack_print<128>(fmt::hex(static_cast<__int128>(-255)), fmt::hex(max)).c_str());
+	ASSERT_EQ(std::string("0000000000000001000000000000000A"), fmt::stack_format<64>("%0", fmt::upperhex_fixed(static_cast<__int128>(1) << 64 | 10)).c_str());
+	ASSERT_EQ(std::string("3777777777777777777777777777777777777777777"), fmt::stack_format<64>("%0", fmt::oct(max)).c_str());
+	ASSERT_TRUE(TestFitsInMaxFormattedSize(max));
+	ASSERT_TRUE(TestFitsInMaxFormattedSize(min));
+	ASSERT_TRUE(TestFitsInMaxFormattedSize(fmt::hex(min)));
+	ASSERT_TRUE(TestFitsInMaxFormattedSize(fmt::oct(min)));
+	std::mt19937_64 random(5);
+	for (int bit = 0; bit < 128; ++bit)
+	{
+		unsigned __int128 power = static_cast<unsigned __int128>(1) << bit;
+		unsigned __int128 noise = (static_cast<unsigned __int128>(random()) << 64 | random()) & (power - 1);
+		for (unsigned __int128 value : { power - 1, power, power + 1, power | noise })
+		{
+			std::string decimal = SlowInt128ToString(value, 10, "0123456789");
+			ASSERT_EQ(decimal, fmt::stack_format<64>("%0", value).c_str());
+			ASSERT_EQ(decimal.size(), size_t(fmt::detail::digits10(value)));
+			ASSERT_EQ(SlowInt128ToString(value, 16, "0123456789abcdef"), fmt::stack_format<64>("%0", fmt::hex(value)).c_str());
+			ASSERT_EQ(SlowInt128ToString(value, 16, "0123456789ABCDEF"), fmt::stack_format<64>("%0", fmt::upperhex(value)).c_str());
+			ASSERT_EQ(SlowInt128ToString(value, 8, "01234567"), fmt::stack_format<64>("%0", fmt::oct(value)).c_str());
+		}
+	}
+	for (unsigned __int128 power = 10; power < max / 10; power *= 10)
+	{
+		ASSERT_EQ(SlowInt128ToString(power - 1, 10, "0123456789"), fmt::stack_format<64>("%0", power - 1).c_str());
+		ASSERT_EQ(SlowInt128ToString(power, 10, "0123456789"), fmt::stack_format<64>("%0", power).c_str());
+	}
+}
+#endif
 }
 #endif
@@ -25,7 +25,22 @@ For more information, please refer to <http://unlicense.org/>
 
 #include "format_it.hpp"
 #include <cstdint>
+#include <cstring>
 #include <type_traits>
+#include <limits>
+
+// define FORMAT_NO_SIMD to only use the plain C++ integer conversions
+#if !defined(FORMAT_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64))
+#include <emmintrin.h>
+#define FORMAT_ITOA_SSE2
+#ifdef __SSSE3__
+#include <tmmintrin.h>
+#define FORMAT_HEX_SSSE3
+#endif
+#endif
+#if !defined(FORMAT_NO_INT128) && defined(__SIZEOF_INT128__)
+#define FORMAT_INT128
+#endif
 
 namespace fmt
 {
@@ -63,6 +78,63 @@ upperhex_formatter<T> upperhex(T value)
 {
 	return { value };
 }
+namespace detail
+{
+// std::make_unsigned doesn't know about __int128 in strict standard modes
+template<typename T>
+struct make_unsigned : std::make_unsigned<T>
+{
+};
+#ifdef FORMAT_INT128
+template<>
+struct make_unsigned<__int128>
+{
+	typedef unsigned __int128 type;
+};
+template<>
+struct make_unsigned<unsigned __int128>
+{
+	typedef unsigned __int128 type;
+};
+#endif
+}
+// always prints all sizeof(T) * 2 digits. negative numbers print their two's
+// complement
+template<typename T>
+struct hex_fixed_formatter
+{
+	T value;
+};
+template<typename T>
+hex_fixed_formatter<typename detail::make_unsigned<T>::type> hex_fixed(T value)
+{
+	return { typename detail::make_unsigned<T>::type(value) };
+}
+template<typename T>
+struct upperhex_fixed_formatter
+{
+	T value;
+};
+template<typename T>
+upperhex_fixed_formatter<typename detail::make_unsigned<T>::type> upperhex_fixed(T value)
+{
+	return { typename detail::make_unsigned<T>::type(value) };
+}
+// two digits for every byte in memory order, like a hex dump without spaces
+template<char A>
+struct hex_bytes_formatter
+{
+	const unsigned char * data;
+	size_t size;
+};
+inline hex_bytes_formatter<'a'> hex_bytes(const void * data, size_t size)
+{
+	return { static_cast<const unsigned char *>(data), size };
+}
+inline hex_bytes_formatter<'A'> upperhex_bytes(const void * data, size_t size)
+{
+	return { static_cast<const unsigned char *>(data), size };
+}
 template<typename T>
 struct oct_formatter
 {
@@ -73,6 +145,110 @@ oct_formatter<T> oct(T value)
 {
 	return { value };
 }
+template<>
+struct max_formatted_size<boolalpha_formatter> : std::integral_constant<size_t, 5>
+{
+};
+template<>
+struct max_formatted_size<bool> : std::integral_constant<size_t, 1>
+{
+};
+template<>
+struct max_formatted_size<char> : std::integral_constant<size_t, 1>
+{
+};
+template<>
+struct max_formatted_size<signed char> : std::integral_constant<size_t, 1>
+{
+};
+template<>
+struct max_formatted_size<unsigned char> : std::integral_constant<size_t, 1>
+{
+};
+namespace detail
+{
+template<typename T>
+struct max_decimal_size : std::integral_constant<size_t, std::numeric_limits<T>::digits10 + 1 + std::is_signed<T>::value>
+{
+};
+}
+template<>
+struct max_formatted_size<short> : detail::max_decimal_size<short>
+{
+};
+template<>
+struct max_formatted_size<unsigned short> : detail::max_decimal_size<unsigned short>
+{
+};
+template<>
+struct max_formatted_size<int> : detail::max_decimal_size<int>
+{
+};
+template<>
+struct max_formatted_size<unsigned int> : detail::max_decimal_size<unsigned int>
+{
+};
+template<>
+struct max_formatted_size<long> : detail::max_decimal_size<long>
+{
+};
+template<>
+struct max_formatted_size<unsigned long> : detail::max_decimal_size<unsigned long>
+{
+};
+template<>
+struct max_formatted_size<long long> : detail::max_decimal_size<long long>
+{
+};
+template<>
+struct max_formatted_size<unsigned long long> : detail::max_decimal_size<unsigned long long>
+{
+};
+#ifdef FORMAT_INT128
+// numeric_limits isn't specialized for __int128 in strict standard modes
+template<>
+struct max_formatted_size<__int128> : std::integral_constant<size_t, 40>
+{
+};
+template<>
+struct max_formatted_size<unsigned __int128> : std::integral_constant<size_t, 39>
+{
+};
+#endif
+template<typename T>
+struct max_formatted_size<hex_formatter<T> > : std::integral_constant<size_t, sizeof(T) * 2 + std::is_signed<T>::value>
+{
+};
+template<typename T>
+struct max_formatted_size<upperhex_formatter<T> > : std::integral_constant<size_t, sizeof(T) * 2 + std::is_signed<T>::value>
+{
+};
+template<typename T>
+struct max_formatted_size<hex_fixed_formatter<T> > : std::integral_constant<size_t, sizeof(T) * 2>
+{
+};
+template<typename T>
+struct max_formatted_size<upperhex_fixed_formatter<T> > : std::integral_constant<size_t, sizeof(T) * 2>
+{
+};
+template<typename T>
+struct max_formatted_size<oct_formatter<T> > : std::integral_constant<size_t, (sizeof(T) * 8 + 2) / 3 + std::is_signed<T>::value>
+{
+};
+#ifdef FORMAT_INT128
+template<>
+struct max_formatted_size<hex_formatter<__int128> > : std::integral_constant<size_t, 33>
+{
+};
+template<>
+struct max_formatted_size<upperhex_formatter<__int128> > : std::integral_constant<size_t, 33>
+{
+};
+template<>
+struct max_formatted_size<oct_formatter<__int128> > : std::integral_constant<size_t, 44>
+{
+};
+#endif
 template<typename C, typename It>
 format_it<C, It> format(format_it<C, It> it, bool value)
 {
@@ -96,161 +272,112 @@ format_it<C, It> format(format_it<C, It> it, unsigned char value)
 }
 namespace detail
 {
-// integer printing method from Andrei Alexandrescu:
-// https://www.facebook.com/notes/facebook-engineering/three-optimization-tips-for-c/10151361643253920
-inline int digits8(uint16_t value)
-{
-	if (value < 010) return 1;
-	else if (value < 0100) return 2;
-	else if (value < 01000) return 3;
-	else if (value < 010000) return 4;
-	else if (value < 0100000) return 5;
-	else return 6;
-}
-inline int digits8(uint32_t value)
-{
-	if (value < 010) return 1;
-	else if (value < 0100) return 2;
-	else if (value < 01000) return 3;
-	else if (value < 010000) return 4;
-	else if (value < 0100000) return 5;
-	else if (value < 01000000000)
-	{
-		if (value < 010000000)
-		{
-			if (value < 01000000) return 6;
-			else return 7;
-		}
-		else if (value < 0100000000) return 8;
-		else return 9;
-	}
-	else if (value < 010000000000) return 10;
-	else return 11;
+// the digit counts below are computed from the number of significant bits
+// without any branches. zero counts as one digit
+constexpr int significant_bits(uint32_t value)
+{
+	return 32 - __builtin_clz(value | 1);
 }
-inline int digits8(unsigned long long value)
+constexpr int significant_bits(unsigned long long value)
 {
-	if (value < 010) return 1;
-	else if (value < 0100) return 2;
-	else if (value < 01000) return 3;
-	else if (value < 010000) return 4;
-	else if (value < 0100000000)
-	{
-		if (value < 01000000)
-		{
-			if (value < 0100000) return 5;
-			else return 6;
-		}
-		else if (value < 010000000) return 7;
-		else return 8;
-	}
-	else if (value < 010000000000llu)
-	{
-		if (value < 01000000000) return 9;
-		else return 10;
-	}
-	else if (value < 0100000000000llu) return 11;
-	else return 11 + digits8(value / 0100000000000llu);
+	return 64 - __builtin_clzll(value | 1);
 }
-inline int digits10(uint16_t value)
+#ifdef FORMAT_INT128
+constexpr int significant_bits(unsigned __int128 value)
 {
-	if (value < 10) return 1;
-	else if (value < 100) return 2;
-	else if (value < 1000) return 3;
-	else if (value < 10000) return 4;
-	else return 5;
+	return uint64_t(value >> 64) ? 128 - __builtin_clzll(uint64_t(value >> 64)) : significant_bits(static_cast<unsigned long long>(value));
 }
-inline int digits10(uint32_t value)
+#endif
+static constexpr uint64_t powers_of_10[20] =
 {
-	if (value < 10) return 1;
-	else if (value < 100) return 2;
-	else if (value < 1000) return 3;
-	else if (value < 10000) return 4;
-	else if (value < 100000) return 5;
-	else if (value < 10000000)
-	{
-		if (value < 1000000) return 6;
-		else return 7;
-	}
-	else if (value < 1000000000)
-	{
-		if (value < 100000000) return 8;
-		else return 9;
-	}
-	else return 10;
+	1llu, 10llu, 100llu, 1000llu, 10000llu, 100000llu, 1000000llu, 10000000llu,
+	100000000llu, 1000000000llu, 10000000000llu, 100000000000llu,
+	1000000000000llu, 10000000000000llu, 100000000000000llu,
+	1000000000000000llu, 10000000000000000llu, 100000000000000000llu,
+	1000000000000000000llu, 10000000000000000000llu
+};
+template<typename T>
+constexpr int digits10_from_bits(T value)
+{
+	// 1233 / 4096 is close enough to log10(2) for up to 64 bits. that guess is
+	// either right or one too small
+	int guess = (significant_bits(value) * 1233) >> 12;
+	return guess + 1 - ((value | 1) < powers_of_10[guess]);
 }
-inline int digits10(unsigned long long value)
+constexpr int digits8(uint16_t value)
 {
-	if (value < 10) return 1;
-	else if (value < 100) return 2;
-	else if (value < 1000) return 3;
-	else if (value < 10000) return 4;
-	else if (value < 100000000)
-	{
-		if (value < 1000000)
-		{
-			if (value < 100000) return 5;
-			else return 6;
-		}
-		else if (value < 10000000) return 7;
-		else return 8;
-	}
-	else if (value < 10000000000llu)
-	{
-		if (value < 1000000000) return 9;
-		else return 10;
-	}
-	else return 10 + digits10(value / 10000000000llu);
+	return (significant_bits(uint32_t(value)) + 2) / 3;
+}
+constexpr int digits8(uint32_t value)
+{
+	return (significant_bits(value) + 2) / 3;
+}
+constexpr int digits8(unsigned long long value)
+{
+	return (significant_bits(value) + 2) / 3;
 }
-inline int digits10(unsigned long value)
+constexpr int digits8(unsigned long value)
+{
+	return digits8(static_cast<unsigned long long>(value));
+}
+#ifdef FORMAT_INT128
+constexpr int digits8(unsigned __int128 value)
+{
+	return (significant_bits(value) + 2) / 3;
+}
+#endif
+constexpr int digits10(uint16_t value)
+{
+	return digits10_from_bits(uint32_t(value));
+}
+constexpr int digits10(uint32_t value)
+{
+	return digits10_from_bits(value);
+}
+constexpr int digits10(unsigned long long value)
+{
+	return digits10_from_bits(value);
+}
+constexpr int digits10(unsigned long value)
 {
 	return digits10(static_cast<unsigned long long>(value));
 }
-inline int digits16(uint16_t value)
+#ifdef FORMAT_INT128
+constexpr unsigned __int128 power_of_10_128(int exponent)
 {
-	if (value < 0x10) return 1;
-	else if (value < 0x100) return 2;
-	else if (value < 0x1000) return 3;
-	else return 4;
+	return exponent < 20 ? powers_of_10[exponent] : static_cast<unsigned __int128>(powers_of_10[19]) * powers_of_10[exponent - 19];
 }
-inline int digits16(uint32_t value)
+// the 1233 / 4096 guess is still good enough for 128 bits
+constexpr int digits10(unsigned __int128 value)
 {
-	if (value < 0x10) return 1;
-	else if (value < 0x100) return 2;
-	else if (value < 0x1000) return 3;
-	else if (value < 0x100000)
-	{
-		if (value < 0x10000) return 4;
-		else return 5;
-	}
-	else if (value < 0x10000000)
-	{
-		if (value < 0x1000000) return 6;
-		else return 7;
-	}
-	else return 8;
+	return uint64_t(value >> 64) == 0 ? digits10(static_cast<unsigned long long>(value))
+		: ((significant_bits(value) * 1233) >> 12) + 1 - (value < power_of_10_128((significant_bits(value) * 1233) >> 12));
 }
-inline int digits16(unsigned long long value)
+#endif
+constexpr int digits16(uint16_t value)
 {
-	if (value < 0x10) return 1;
-	else if (value < 0x100) return 2;
-	else if (value < 0x1000) return 3;
-	else if (value < 0x10000000)
-	{
-		if (value < 0x100000)
-		{
-			if (value < 0x10000) return 4;
-			else return 5;
-		}
-		else if (value < 0x1000000) return 6;
-		else return 7;
-	}
-	else if (value < 0x100000000llu) return 8;
-	else return 8 + digits16(value / 0x100000000llu);
+	return (significant_bits(uint32_t(value)) + 3) / 4;
+}
+constexpr int digits16(uint32_t value)
+{
+	return (significant_bits(value) + 3) / 4;
 }
-inline int digits16(unsigned long value)
+constexpr int digits16(unsigned long long value)
+{
+	return (significant_bits(value) + 3) / 4;
+}
+constexpr int digits16(unsigned long value)
 {
 	return digits16(static_cast<unsigned long long>(value));
 }
+#ifdef FORMAT_INT128
+constexpr int digits16(unsigned __int128 value)
+{
+	return (significant_bits(value) + 3) / 4;
+}
+#endif
+// integer printing method from Andrei Alexandrescu:
+// https://www.facebook.com/notes/facebook-engineering/three-optimization-tips-for-c/10151361643253920
 static constexpr const char oct_digits[129] =
 		"0001020304050607"
 		"1011121314151617"
@@ -313,6 +440,89 @@ inline char * itoa_base10(T value, char * buffer)
 	}
 	return last;
 }
+#ifdef FORMAT_ITOA_SSE2
+// the eight digits of a value below 10^8 in 16 bit lanes. this uses
+// multiplications and shifts instead of divisions. the idea is by Wojciech Muła
+inline __m128i eight_digits_sse2(uint32_t value)
+{
+	// abcd, efgh = abcdefgh divmod 10000
+	__m128i abcdefgh = _mm_cvtsi32_si128(int(value));
+	__m128i abcd = _mm_srli_epi64(_mm_mul_epu32(abcdefgh, _mm_set1_epi32(int(0xd1b71759))), 45);
+	__m128i efgh = _mm_sub_epi32(abcdefgh, _mm_mul_epu32(abcd, _mm_set1_epi32(10000)));
+	// [abcd * 4, abcd * 4, abcd * 4, abcd * 4, efgh * 4, efgh * 4, efgh * 4, efgh * 4]
+	__m128i both = _mm_slli_epi64(_mm_unpacklo_epi16(abcd, efgh), 2);
+	both = _mm_unpacklo_epi16(both, both);
+	both = _mm_unpacklo_epi32(both, both);
+	// divide by 1000, 100, 10 and 1: [a, ab, abc, abcd, e, ef, efg, efgh]
+	__m128i prefixes = _mm_mulhi_epu16(both, _mm_setr_epi16(8389, 5243, 13108, -32768, 8389, 5243, 13108, -32768));
+	prefixes = _mm_mulhi_epu16(prefixes, _mm_setr_epi16(1 << 7, 1 << 11, 1 << 13, -32768, 1 << 7, 1 << 11, 1 << 13, -32768));
+	// subtract ten times the lane before: [a, b, c, d, e, f, g, h]
+	return _mm_sub_epi16(prefixes, _mm_slli_epi64(_mm_mullo_epi16(prefixes, _mm_set1_epi16(10)), 16));
+}
+// sixteen ascii digits of a value below 10^16, with leading zeros
+inline __m128i sixteen_digits_sse2(uint64_t value)
+{
+	__m128i digits = _mm_packus_epi16(eight_digits_sse2(uint32_t(value / 100000000)), eight_digits_sse2(uint32_t(value % 100000000)));
+	return _mm_add_epi8(digits, _mm_set1_epi8('0'));
+}
+inline char * itoa_base10(uint32_t value, char * buffer)
+{
+	if (value < 100000000) return itoa_base10<uint32_t>(value, buffer);
+	char * next = itoa_base10<uint32_t>(value / 100000000, buffer);
+	__m128i digits = _mm_packus_epi16(eight_digits_sse2(value % 100000000), _mm_setzero_si128());
+	_mm_storel_epi64(reinterpret_cast<__m128i *>(next), _mm_add_epi8(digits, _mm_set1_epi8('0')));
+	return next + 8;
+}
+inline char * itoa_base10(unsigned long long value, char * buffer)
+{
+	if (value < 100000000) return itoa_base10<uint32_t>(uint32_t(value), buffer);
+	else if (value < 10000000000000000llu)
+	{
+		int length = digits10(value);
+		alignas(16) char digits[16];
+		_mm_store_si128(reinterpret_cast<__m128i *>(digits), sixteen_digits_sse2(value));
+		std::memcpy(buffer, digits + 16 - length, length);
+		return buffer + length;
+	}
+	else
+	{
+		char * next = itoa_base10<uint32_t>(uint32_t(value / 10000000000000000llu), buffer);
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(next), sixteen_digits_sse2(value % 10000000000000000llu));
+		return next + 16;
+	}
+}
+inline char * itoa_base10(unsigned long value, char * buffer)
+{
+	return itoa_base10(static_cast<unsigned long long>(value), buffer);
+}
+#endif
+#ifdef FORMAT_INT128
+// exactly nineteen digits of a value below 10^19, with leading zeros
+inline char * nineteen_digits(unsigned long long value, char * buffer)
+{
+	int length = digits10(value);
+	std::memset(buffer, '0', 19 - length);
+	return itoa_base10(value, buffer + 19 - length);
+}
+// splits into chunks of 10^19 so that every chunk goes through the 64 bit code
+inline char * itoa_base10(unsigned __int128 value, char * buffer)
+{
+	if (uint64_t(value >> 64) == 0) return itoa_base10(static_cast<unsigned long long>(value), buffer);
+	static constexpr unsigned long long chunk = 10000000000000000000llu;
+	unsigned __int128 high = value / chunk;
+	unsigned long long low = static_cast<unsigned long long>(value - high * chunk);
+	char * next;
+	if (uint64_t(high >> 64) == 0) next = itoa_base10(static_cast<unsigned long long>(high), buffer);
+	else
+	{
+		// high is below 2^128 / 10^19, so the top chunk is a single digit
+		unsigned long long middle = static_cast<unsigned long long>(high % chunk);
+		*buffer = char('0' + static_cast<int>(high / chunk));
+		next = nineteen_digits(middle, buffer + 1);
+	}
+	return nineteen_digits(low, next);
+}
+#endif
 static constexpr const char hex_lower_digits[513] =
 		"000102030405060708090a0b0c0d0e0f"
 		"101112131415161718191a1b1c1d1e1f"
@@ -369,6 +579,113 @@ inline char * itoa_base16(T value, char * buffer, const char digits[513])
 	}
 	return last;
 }
+template<char A>
+constexpr const char * hex_digits()
+{
+	return A == 'a' ? hex_lower_digits : hex_upper_digits;
+}
+// writes exactly sizeof(T) * 2 digits
+template<char A, typename T>
+inline char * hex_fixed_scalar(T value, char * buffer)
+{
+	for (int i = int(sizeof(T)) - 1; i >= 0; --i)
+	{
+		auto index = (value & 0xff) * 2;
+		value = T(value >> 8);
+		buffer[i * 2] = hex_digits<A>()[index];
+		buffer[i * 2 + 1] = hex_digits<A>()[index + 1];
+	}
+	return buffer + sizeof(T) * 2;
+}
+#ifdef FORMAT_ITOA_SSE2
+// turns the nibbles in each byte into digits
+template<char A>
+inline __m128i nibbles_to_hex_sse2(__m128i nibbles)
+{
+#ifdef FORMAT_HEX_SSSE3
+	return _mm_shuffle_epi8(_mm_setr_epi8('0', '1', '2', '3', '4', '5', '6', '7', '8', '9', A, A + 1, A + 2, A + 3, A + 4, A + 5), nibbles);
+#else
+	__m128i letters = _mm_and_si128(_mm_cmpgt_epi8(nibbles, _mm_set1_epi8(9)), _mm_set1_epi8(A - '0' - 10));
+	return _mm_add_epi8(_mm_add_epi8(nibbles, _mm_set1_epi8('0')), letters);
+#endif
+}
+// the digits of the first eight bytes go into low, the rest into high
+template<char A>
+inline void bytes_to_hex_sse2(__m128i bytes, __m128i & low, __m128i & high)
+{
+	__m128i mask = _mm_set1_epi8(0xf);
+	__m128i high_nibbles = _mm_and_si128(_mm_srli_epi16(bytes, 4), mask);
+	__m128i low_nibbles = _mm_and_si128(bytes, mask);
+	low = nibbles_to_hex_sse2<A>(_mm_unpacklo_epi8(high_nibbles, low_nibbles));
+	high = nibbles_to_hex_sse2<A>(_mm_unpackhi_epi8(high_nibbles, low_nibbles));
+}
+template<char A>
+inline char * hex_fixed_sse2(unsigned long long value, char * buffer)
+{
+	__m128i low, high;
+	bytes_to_hex_sse2<A>(_mm_cvtsi64_si128(static_cast<long long>(__builtin_bswap64(value))), low, high);
+	_mm_storeu_si128(reinterpret_cast<__m128i *>(buffer), low);
+	return buffer + 16;
+}
+template<char A>
+inline char * hex_fixed_sse2(uint32_t value, char * buffer)
+{
+	__m128i low, high;
+	bytes_to_hex_sse2<A>(_mm_cvtsi32_si128(static_cast<int>(__builtin_bswap32(value))), low, high);
+	_mm_storel_epi64(reinterpret_cast<__m128i *>(buffer), low);
+	return buffer + 8;
+}
+#endif
+template<char A, typename T>
+inline char * hex_fixed(T value, char * buffer)
+{
+	return hex_fixed_scalar<A>(value, buffer);
+}
+#ifdef FORMAT_ITOA_SSE2
+template<char A>
+inline char * hex_fixed(uint32_t value, char * buffer)
+{
+	return hex_fixed_sse2<A>(value, buffer);
+}
+template<char A>
+inline char * hex_fixed(unsigned long long value, char * buffer)
+{
+	return hex_fixed_sse2<A>(value, buffer);
+}
+template<char A>
+inline char * hex_fixed(unsigned long value, char * buffer)
+{
+	return hex_fixed_sse2<A>(static_cast<unsigned long long>(value), buffer);
+}
+#endif
+#ifdef FORMAT_INT128
+template<char A>
+inline char * hex_fixed(unsigned __int128 value, char * buffer)
+{
+	char * next = hex_fixed<A>(static_cast<unsigned long long>(value >> 64), buffer);
+	return hex_fixed<A>(static_cast<unsigned long long>(value), next);
+}
+#endif
+// buffer needs space for (end - begin) * 2 characters
+template<char A>
+inline char * hex_bytes_into(const unsigned char * begin, const unsigned char * end, char * buffer)
+{
+#ifdef FORMAT_ITOA_SSE2
+	for (; end - begin >= 16; begin += 16, buffer += 32)
+	{
+		__m128i low, high;
+		bytes_to_hex_sse2<A>(_mm_loadu_si128(reinterpret_cast<const __m128i *>(begin)), low, high);
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(buffer), low);
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(buffer + 16), high);
+	}
+#endif
+	for (; begin != end; ++begin, buffer += 2)
+	{
+		buffer[0] = hex_digits<A>()[*begin * 2];
+		buffer[1] = hex_digits<A>()[*begin * 2 + 1];
+	}
+	return buffer;
+}
 }
 template<typename C, typename It, typename T>
 format_it<C, It> format_signed(format_it<C, It> it, T value)
@@ -376,15 +693,15 @@ format_it<C, It> format_signed(format_it<C, It> it, T value)
 	if (value < 0)
 	{
 		*it++ = C('-');
-		return format(it, typename std::make_unsigned<T>::type(-value));
+		return format(it, typename detail::make_unsigned<T>::type(-value));
 	}
-	else return format(it, typename std::make_unsigned<T>::type(value));
+	else return format(it, typename detail::make_unsigned<T>::type(value));
 }
 template<typename C, typename It>
 format_it<C, It> format(format_it<C, It> it, uint16_t value)
 {
 	char buffer[5];
-	return std::copy(buffer, detail::itoa_base10(value, buffer), it);
+	return detail::write_chars(it, buffer, detail::itoa_base10(value, buffer));
 }
 template<typename C, typename It>
 format_it<C, It> format(format_it<C, It> it, int16_t value)
@@ -395,7 +712,7 @@ template<typename C, typename It>
 format_it<C, It> format(format_it<C, It> it, uint32_t value)
 {
 	char buffer[10];
-	return std::copy(buffer, detail::itoa_base10(value, buffer), it);
+	return detail::write_chars(it, buffer, detail::itoa_base10(value, buffer));
 }
 template<typename C, typename It>
 format_it<C, It> format(format_it<C, It> it, int32_t value)
@@ -406,7 +723,7 @@ template<typename C, typename It>
 format_it<C, It> format(format_it<C, It> it, unsigned long long value)
 {
 	char buffer[20];
-	return std::copy(buffer, detail::itoa_base10(value, buffer), it);
+	return detail::write_chars(it, buffer, detail::itoa_base10(value, buffer));
 }
 template<typename C, typename It>
 format_it<C, It> format(format_it<C, It> it, long long value)
@@ -423,6 +740,19 @@ format_it<C, It> format(format_it<C, It> it, long value)
 {
 	return format_signed(it, value);
 }
+#ifdef FORMAT_INT128
+template<typename C, typename It>
+format_it<C, It> format(format_it<C, It> it, unsigned __int128 value)
+{
+	char buffer[39];
+	return detail::write_chars(it, buffer, detail::itoa_base10(value, buffer));
+}
+template<typename C, typename It>
+format_it<C, It> format(format_it<C, It> it, __int128 value)
+{
+	return format_signed(it, value);
+}
+#endif
 template<typename C, typename It>
 format_it<C, It> format(format_it<C, It> it, hex_formatter<uint8_t> value)
 {
@@ -440,34 +770,46 @@ template<typename C, typename It>
 format_it<C, It> format(format_it<C, It> it, hex_formatter<uint16_t> value)
 {
 	char buffer[4];
-	return std::copy(buffer, detail::itoa_base16<'a'>(value.value, buffer, detail::hex_lower_digits), it);
+	return detail::write_chars(it, buffer, detail::itoa_base16<'a'>(value.value, buffer, detail::hex_lower_digits));
 }
 template<typename C, typename It>
 format_it<C, It> format(format_it<C, It> it, hex_formatter<uint32_t> value)
 {
 	char buffer[8];
-	return std::copy(buffer, detail::itoa_base16<'a'>(value.value, buffer, detail::hex_lower_digits), it);
+	return detail::write_chars(it, buffer, detail::itoa_base16<'a'>(value.value, buffer, detail::hex_lower_digits));
 }
 template<typename C, typename It>
 format_it<C, It> format(format_it<C, It> it, hex_formatter<unsigned long long> value)
 {
 	char buffer[16];
-	return std::copy(buffer, detail::itoa_base16<'a'>(value.value, buffer, detail::hex_lower_digits), it);
+	return detail::write_chars(it, buffer, detail::itoa_base16<'a'>(value.value, buffer, detail::hex_lower_digits));
 }
 template<typename C, typename It>
 format_it<C, It> format(format_it<C, It> it, hex_formatter<unsigned long> value)
 {
 	return format(it, hex(static_cast<unsigned long long>(value.value)));
 }
+#ifdef FORMAT_INT128
+template<typename C, typename It>
+format_it<C, It> format(format_it<C, It> it, hex_formatter<unsigned __int128> value)
+{
+	unsigned long long high = static_cast<unsigned long long>(value.value >> 64);
+	if (high == 0) return format(it, hex(static_cast<unsigned long long>(value.value)));
+	// below the top half every half has all sixteen digits
+	char buffer[32];
+	char * next = detail::itoa_base16<'a'>(high, buffer, detail::hex_lower_digits);
+	return detail::write_chars(it, buffer, detail::hex_fixed<'a'>(static_cast<unsigned long long>(value.value), next));
+}
+#endif
 template<typename C, typename It, typename T>
 format_it<C, It> format(format_it<C, It> it, hex_formatter<T> value)
 {
 	if (value.value < 0)
 	{
 		*it++ = C('-');
-		return format(it, hex(typename std::make_unsigned<T>::type(-value.value)));
+		return format(it, hex(typename detail::make_unsigned<T>::type(-value.value)));
 	}
-	else return format(it, hex(typename std::make_unsigned<T>::type(value.value)));
+	else return format(it, hex(typename detail::make_unsigned<T>::type(value.value)));
 }
 template<typename C, typename It>
 format_it<C, It> format(format_it<C, It> it, upperhex_formatter<uint8_t> value)
@@ -486,34 +828,71 @@ template<typename C, typename It>
 format_it<C, It> format(format_it<C, It> it, upperhex_formatter<uint16_t> value)
 {
 	char buffer[4];
-	return std::copy(buffer, detail::itoa_base16<'A'>(value.value, buffer, detail::hex_upper_digits), it);
+	return detail::write_chars(it, buffer, detail::itoa_base16<'A'>(value.value, buffer, detail::hex_upper_digits));
 }
 template<typename C, typename It>
 format_it<C, It> format(format_it<C, It> it, upperhex_formatter<uint32_t> value)
 {
 	char buffer[8];
-	return std::copy(buffer, detail::itoa_base16<'A'>(value.value, buffer, detail::hex_upper_digits), it);
+	return detail::write_chars(it, buffer, detail::itoa_base16<'A'>(value.value, buffer, detail::hex_upper_digits));
 }
 template<typename C, typename It>
 format_it<C, It> format(format_it<C, It> it, upperhex_formatter<unsigned long long> value)
 {
 	char buffer[16];
-	return std::copy(buffer, detail::itoa_base16<'A'>(value.value, buffer, detail::hex_upper_digits), it);
+	return detail::write_chars(it, buffer, detail::itoa_base16<'A'>(value.value, buffer, detail::hex_upper_digits));
 }
 template<typename C, typename It>
 format_it<C, It> format(format_it<C, It> it, upperhex_formatter<unsigned long> value)
 {
 	return format(it, upperhex(static_cast<unsigned long long>(value.value)));
 }
+#ifdef FORMAT_INT128
+template<typename C, typename It>
+format_it<C, It> format(format_it<C, It> it, upperhex_formatter<unsigned __int128> value)
+{
+	unsigned long long high = static_cast<unsigned long long>(value.value >> 64);
+	if (high == 0) return format(it, upperhex(static_cast<unsigned long long>(value.value)));
+	// below the top half every half has all sixteen digits
+	char buffer[32];
+	char * next = detail::itoa_base16<'A'>(high, buffer, detail::hex_upper_digits);
+	return detail::write_chars(it, buffer, detail::hex_fixed<'A'>(static_cast<unsigned long long>(value.value), next));
+}
+#endif
 template<typename C, typename It, typename T>
 format_it<C, It> format(format_it<C, It> it, upperhex_formatter<T> value)
 {
 	if (value.value < 0)
 	{
 		*it++ = C('-');
-		return format(it, upperhex(typename std::make_unsigned<T>::type(-value.value)));
+		return format(it, upperhex(typename detail::make_unsigned<T>::type(-value.value)));
+	}
+	else return format(it, upperhex(typename detail::make_unsigned<T>::type(value.value)));
+}
+template<typename C, typename It, typename T>
+format_it<C, It> format(format_it<C, It> it, hex_fixed_formatter<T> value)
+{
+	char buffer[sizeof(T) * 2];
+	return detail::write_chars(it, buffer, detail::hex_fixed<'a'>(value.value, buffer));
+}
+template<typename C, typename It, typename T>
+format_it<C, It> format(format_it<C, It> it, upperhex_fixed_formatter<T> value)
+{
+	char buffer[sizeof(T) * 2];
+	return detail::write_chars(it, buffer, detail::hex_fixed<'A'>(value.value, buffer));
+}
+template<typename C, typename It, char A>
+format_it<C, It> format(format_it<C, It> it, hex_bytes_formatter<A> value)
+{
+	char buffer[1024];
+	const unsigned char * end = value.data + value.size;
+	for (const unsigned char * chunk = value.data; chunk != end;)
+	{
+		const unsigned char * chunk_end = chunk + std::min(size_t(end - chunk), sizeof(buffer) / 2);
+		it = detail::write_chars(it, buffer, detail::hex_bytes_into<A>(chunk, chunk_end, buffer));
+		chunk = chunk_end;
 	}
-	else return format(it, upperhex(typename std::make_unsigned<T>::type(value.value)));
+	return it;
 }
 template<typename C, typename It>
 format_it<C, It> format(format_it<C, It> it, oct_formatter<uint8_t> value)
@@ -533,33 +912,88 @@ template<typename C, typename It>
 format_it<C, It> format(format_it<C, It> it, oct_formatter<uint16_t> value)
 {
 	char buffer[6];
-	return std::copy(buffer, detail::itoa_base8(value.value, buffer), it);
+	return detail::write_chars(it, buffer, detail::itoa_base8(value.value, buffer));
 }
 template<typename C, typename It>
 format_it<C, It> format(format_it<C, It> it, oct_formatter<uint32_t> value)
 {
 	char buffer[11];
-	return std::copy(buffer, detail::itoa_base8(value.value, buffer), it);
+	return detail::write_chars(it, buffer, detail::itoa_base8(value.value, buffer));
 }
 template<typename C, typename It>
 format_it<C, It> format(format_it<C, It> it, oct_formatter<unsigned long long> value)
 {
 	char buffer[22];
-	return std::copy(buffer, detail::itoa_base8(value.value, buffer), it);
+	return detail::write_chars(it, buffer, detail::itoa_base8(value.value, buffer));
 }
 template<typename C, typename It>
 format_it<C, It> format(format_it<C, It> it, oct_formatter<unsigned long> value)
 {
 	return format(it, oct(static_cast<unsigned long long>(value.value)));
 }
+#ifdef FORMAT_INT128
+template<typename C, typename It>
+format_it<C, It> format(format_it<C, It> it, oct_formatter<unsigned __int128> value)
+{
+	if (uint64_t(value.value >> 64) == 0) return format(it, oct(static_cast<unsigned long long>(value.value)));
+	char buffer[43];
+	return detail::write_chars(it, buffer, detail::itoa_base8(value.value, buffer));
+}
+#endif
 template<typename C, typename It, typename T>
 format_it<C, It> format(format_it<C, It> it, oct_formatter<T> value)
 {
 	if (value.value < 0)
 	{
 		*it++ = C('-');
-		return format(it, oct(typename std::make_unsigned<T>::type(-value.value)));
+		return format(it, oct(typename detail::make_unsigned<T>::type(-value.value)));
+	}
+	else return format(it, oct(typename detail::make_unsigned<T>::type(value.value)));
+}
+template<typename C, typename It>
+struct formatter<const void *, C, It>
+{
+	format_it<C, It> operator()(format_it<C, It> it, const void * value) const
+	{
+		*it++ = C('0');
+		*it++ = C('x');
+		return format(it, hex(reinterpret_cast<uintptr_t>(value)));
 	}
-	else return format(it, oct(typename std::make_unsigned<T>::type(value.value)));
+};
+template<typename C, typename It>
+struct formatter<void *, C, It> : formatter<const void *, C, It>
+{
+};
+template<>
+struct max_formatted_size<const void *> : std::integral_constant<size_t, 2 + sizeof(void *) * 2>
+{
+};
+template<>
+struct max_formatted_size<void *> : max_formatted_size<const void *>
+{
+};
+namespace detail
+{
+// only finds operator<< overloads that are free functions. the ones for the
+// builtin integer types are members of basic_ostream and don't count
+template<typename T, typename C, typename Enable = void>
+struct has_stream_operator : std::false_type
+{
+};
+template<typename T, typename C>
+struct has_stream_operator<T, C, decltype(operator<<(std::declval<std::basic_ostream<C> &>(), std::declval<const T &>()), void())> : std::true_type
+{
+};
 }
+// enums print their underlying value, like the ostream does for unscoped
+// enums. enums with their own operator<< keep using it. so do unscoped enums
+// with a char sized underlying type, which the ostream prints as a character
+template<typename T, typename C, typename It>
+struct formatter<T, C, It, typename std::enable_if<std::is_enum<T>::value && !detail::has_stream_operator<T, C>::value>::type>
+{
+	format_it<C, It> operator()(format_it<C, It> it, T value) const
+	{
+		return format(it, +static_cast<typename std::underlying_type<T>::type>(value));
+	}
+};
 }
@@ -112,6 +112,55 @@ TEST(format_it, invalid_format_string)
 	}
 	ASSERT_TRUE(did_throw);
 }
+struct counting_write_it : std::iterator<std::output_iterator_tag, void, void, void, void>
+{
+	counting_write_it(std::string & out)
+		: out(&out)
+	{
+	}
+	counting_write_it & operator=(char c)
+	{
+		out->push_back(c);
+		++num_chars;
+		return *this;
+	}
+	counting_write_it & operator*()
+	{
+		return *this;
+	}
+	counting_write_it & operator++()
+	{
+		return *this;
+	}
+	counting_write_it & operator++(int)
+	{
+		return *this;
+	}
+	void write(const char * begin, const char * end)
+	{
+		out->append(begin, end);
+		++num_writes;
+	}
+
+	std::string * out;
+	int num_chars = 0;
+	int num_writes = 0;
+};
+TEST(format_it, bulk_write)
+{
+	std::string out;
+	auto it = fmt::make_format_it(counting_write_it(out));
+	it.format("[%0, %1, %2]", "Hello", std::string("World"), 12345);
+	ASSERT_EQ("[Hello, World, 12345]", out);
+	ASSERT_EQ(0, it.it().num_chars);
+	ASSERT_EQ(7, it.it().num_writes);
+}
+TEST(format_it, bulk_write_back_inserter)
+{
+	std::vector<char> out;
+	fmt::make_format_it(std::back_inserter(out)).format(std::string("%0: %1"), "foo", 10);
+	ASSERT_EQ("foo: 10", std::string(out.begin(), out.end()));
+}
 TEST(format_it, print_separator)
 {
 	std::string print;
@@ -127,5 +176,44 @@ TEST(format_it, print_separator)
 	fmt::make_format_it<char>(std::back_inserter(print_separated)).print_separated(", ", "Hello","World","!");
 	ASSERT_EQ("Hello, World, !", print_separated);
 }
+enum unscoped_enum { unscoped_value = 3 };
+enum class scoped_enum : char { value = 65 };
+enum class named_enum { value };
+std::ostream & operator<<(std::ostream & lhs, named_enum)
+{
+	return lhs << "named";
+}
+struct streamable
+{
+	int value;
+};
+std::ostream & operator<<(std::ostream & lhs, const streamable & value)
+{
+	return lhs << '<' << value.value << '>';
+}
+TEST(format_it, native_types)
+{
+	std::string out;
+	int local = 0;
+	const void * pointer = &local;
+	std::ostringstream expected_pointer;
+	expected_pointer << pointer;
+	fmt::make_format_it<char>(std::back_inserter(out)).print(nullptr, pointer, unscoped_value, scoped_enum::value, named_enum::value);
+	ASSERT_EQ("nullptr " + expected_pointer.str() + " 3 65 named", out);
+	out.clear();
+	fmt::make_format_it<char>(std::back_inserter(out)).print(static_cast<void *>(nullptr));
+	ASSERT_EQ("0x0", out);
+#ifdef FORMAT_STRING_VIEW
+	std::wstring wout;
+	fmt::make_format_it<wchar_t>(std::back_inserter(wout)).format(L"[%0]", std::wstring_view(L"view of a string", 7));
+	ASSERT_EQ(L"[view of]", wout);
+#endif
+}
+TEST(format_it, ostream_fallback)
+{
+	std::string out;
+	fmt::make_format_it<char>(std::back_inserter(out)).format("%0 %1", streamable{ 5 }, streamable{ -1 });
+	ASSERT_EQ("<5> <-1>", out);
+}
 }
 #endif
@@ -26,10 +26,17 @@ For more information, please refer to <http://unlicense.org/>
 #include <string>
 #include <algorithm>
 #include <iterator>
+#include <memory>
 #include <ostream>
 #include <vector>
-#include <deque>
 #include <cstring>
+#include <cstddef>
+#include <cassert>
+#include <type_traits>
+#if __cplusplus >= 201703L
+#include <string_view>
+#define FORMAT_STRING_VIEW
+#endif
 
 #define FORMAT_NO_INLINE __attribute__((noinline))
 
@@ -39,6 +46,28 @@ template<typename C, typename It>
 struct format_it;
 template<typename T, typename C, typename It, typename Enable = void>
 struct formatter;
+template<typename S>
+struct compiled_format;
+template<typename C>
+struct cached_format_string;
+
+// the maximum number of characters that formatting a T can produce. only
+// defined for types where that is known at compile time. for more than one
+// type it's the sum over all of them
+template<typename... T>
+struct max_formatted_size;
+template<>
+struct max_formatted_size<> : std::integral_constant<size_t, 0>
+{
+};
+template<typename First, typename Second, typename... Rest>
+struct max_formatted_size<First, Second, Rest...> : std::integral_constant<size_t, max_formatted_size<First>::value + max_formatted_size<Second, Rest...>::value>
+{
+};
+template<typename C, size_t Size>
+struct max_formatted_size<C[Size]> : std::integral_constant<size_t, Size - 1>
+{
+};
 }
 
 template<typename C, typename It, typename T>
@@ -65,12 +94,12 @@ struct iterator_streambuf : std::basic_streambuf<C>
 
 	virtual std::streamsize xsputn(const C * s, std::streamsize size) override
 	{
-		it = std::copy(s, s + size, it);
+		it.write(s, s + size);
 		return size;
 	}
 	virtual int_type overflow(int_type ch = traits_type::eof()) override
 	{
-		if (!traits_type::eq_int_type(ch, traits_type::eof())) *it++ = ch;
+		if (!traits_type::eq_int_type(ch, traits_type::eof())) *it++ = traits_type::to_char_type(ch);
 		return traits_type::eof() + 1;
 	}
 };
@@ -79,6 +108,109 @@ format_it<C, It> adl_format(format_it<C, It> it, const T & value)
 {
 	return format(it, value);
 }
+// sinks can write a whole range at once by providing a member function
+// void write(const C * begin, const C * end). all others get written
+// one character at a time
+template<typename It, typename C, typename Enable = void>
+struct sink_write
+{
+	static void write(It & it, const C * begin, const C * end)
+	{
+		it = std::copy(begin, end, it);
+	}
+};
+template<typename It, typename C>
+struct sink_write<It, C, decltype(std::declval<It &>().write(std::declval<const C *>(), std::declval<const C *>()), void())>
+{
+	static void write(It & it, const C * begin, const C * end)
+	{
+		it.write(begin, end);
+	}
+};
+// writes without checking for the end of the buffer. only use this if the
+// buffer is known to be big enough
+template<typename C>
+struct unchecked_format_it : std::iterator<std::output_iterator_tag, void, void, void, void>
+{
+	explicit unchecked_format_it(C * buffer)
+		: buffer(buffer)
+	{
+	}
+	inline unchecked_format_it & operator=(C c)
+	{
+		*buffer++ = c;
+		return *this;
+	}
+	inline void write(const C * begin, const C * end)
+	{
+		std::memcpy(buffer, begin, (end - begin) * sizeof(C));
+		buffer += end - begin;
+	}
+	unchecked_format_it & operator*()
+	{
+		return *this;
+	}
+	unchecked_format_it & operator++()
+	{
+		return *this;
+	}
+	unchecked_format_it & operator++(int)
+	{
+		return *this;
+	}
+
+	C * buffer;
+};
+// sinks that write into memory can provide the functions
+// C * unchecked_begin(size_t size) and void unchecked_end(C * end). the first
+// returns a pointer to space for at least size characters, or nullptr if
+// there isn't enough space. the second is called with the end of what was
+// written. format_it uses that for types with a max_formatted_size, so that
+// all characters of that value can be written without further checks
+template<typename C, typename It, typename T, typename Enable = void>
+struct bounded_format
+{
+	static format_it<C, It> format(format_it<C, It> it, const T & value)
+	{
+		return adl_format(it, value);
+	}
+};
+template<typename C, typename It, typename T>
+struct bounded_format<C, It, T, decltype(std::declval<It &>().unchecked_begin(max_formatted_size<T>::value), void())>
+{
+	static format_it<C, It> format(format_it<C, It> it, const T & value)
+	{
+		It sink = it.it();
+		C * begin = sink.unchecked_begin(max_formatted_size<T>::value);
+		if (!begin) return adl_format(it, value);
+		format_it<C, unchecked_format_it<C> > unchecked = adl_format(format_it<C, unchecked_format_it<C> >(unchecked_format_it<C>(begin)), value);
+		// if this fires, max_formatted_size<T> is too small and we've already
+		// written past the space that the sink gave us
+		assert(size_t(unchecked.it().buffer - begin) <= max_formatted_size<T>::value);
+		sink.unchecked_end(unchecked.it().buffer);
+		it.it(std::move(sink));
+		return it;
+	}
+};
+// std::back_insert_iterator doesn't have a write function, but the container
+// it points to is a protected member so we can get at it and append directly
+template<typename Container>
+struct back_insert_container : std::back_insert_iterator<Container>
+{
+	static Container & get(std::back_insert_iterator<Container> & it)
+	{
+		return *(it.*&back_insert_container::container);
+	}
+};
+template<typename Container, typename C>
+struct sink_write<std::back_insert_iterator<Container>, C>
+{
+	static void write(std::back_insert_iterator<Container> & it, const C * begin, const C * end)
+	{
+		Container & container = back_insert_container<Container>::get(it);
+		container.insert(container.end(), begin, end);
+	}
+};
 }
 struct format_error : std::runtime_error
 {
@@ -101,6 +233,40 @@ private:
 	Reason _reason;
 };
 
+namespace detail
+{
+template<typename C, typename It, typename T>
+void format_erased(format_it<C, It> & it, const void * value)
+{
+	it = *static_cast<const T *>(value);
+}
+// the arguments of one format call, so that "%13" is one indirect call
+// instead of walking through thirteen arguments. the table of functions
+// exists once per combination of argument types
+template<typename C, typename It, typename... Args>
+struct format_arguments
+{
+	typedef void (*format_function)(format_it<C, It> &, const void *);
+
+	explicit format_arguments(const Args &... args)
+		: values{ std::addressof(args)..., nullptr }
+	{
+	}
+	void format(format_it<C, It> & it, int i) const
+	{
+		if (unsigned(i) >= sizeof...(Args)) throw format_error(format_error::FormatIndexOutOfRange);
+		functions[i](it, values[i]);
+	}
+
+private:
+	// one longer than needed because arrays can't be empty
+	const void * values[sizeof...(Args) + 1];
+	static constexpr format_function functions[sizeof...(Args) + 1] = { &format_erased<C, It, Args>..., nullptr };
+};
+template<typename C, typename It, typename... Args>
+constexpr typename format_arguments<C, It, Args...>::format_function format_arguments<C, It, Args...>::functions[sizeof...(Args) + 1];
+}
+
 template<typename C, typename It>
 struct format_it : std::iterator<std::output_iterator_tag, void, void, void, void>
 {
@@ -128,7 +294,12 @@ struct format_it : std::iterator<std::output_iterator_tag, void, void, void, voi
 	template<typename T>
 	format_it & operator=(const T & value)
 	{
-		return *this = detail::adl_format(*this, value);
+		return *this = detail::bounded_format<C, It, T>::format(*this, value);
+	}
+	format_it & write(const C * begin, const C * end)
+	{
+		detail::sink_write<It, C>::write(_it, begin, end);
+		return *this;
 	}
 
 	template<size_t FormatSize, typename... Args>
@@ -144,17 +315,44 @@ struct format_it : std::iterator<std::output_iterator_tag, void, void, void, voi
 	template<typename Traits, typename Allocator, typename... Args>
 	format_it & format(const std::basic_string<C, Traits, Allocator> & format_string, const Args &... args)
 	{
-		return format(format_string.begin(), format_string.end(), args...);
+		return format(format_string.data(), format_string.data() + format_string.size(), args...);
 	}
 	template<typename Traits, typename Allocator, typename First, typename... Args>
 	format_it & format(const std::basic_string<C, Traits, Allocator> & format_string, const First & first, const Args &... args)
 	{
-		return format(format_string.begin(), format_string.end(), first, args...);
+		return format(format_string.data(), format_string.data() + format_string.size(), first, args...);
+	}
+	// see format_compile.hpp
+	template<typename S, typename... Args>
+	format_it & format(compiled_format<S>, const Args &... args)
+	{
+		compiled_format<S>::format(*this, args...);
+		return *this;
+	}
+	template<typename S, typename First, typename... Args>
+	format_it & format(compiled_format<S>, const First & first, const Args &... args)
+	{
+		compiled_format<S>::format(*this, first, args...);
+		return *this;
+	}
+	// see format_cache.hpp
+	template<typename... Args>
+	format_it & format(const cached_format_string<C> & format_string, const Args &... args)
+	{
+		format_string.format(*this, args...);
+		return *this;
+	}
+	template<typename First, typename... Args>
+	format_it & format(const cached_format_string<C> & format_string, const First & first, const Args &... args)
+	{
+		format_string.format(*this, first, args...);
+		return *this;
 	}
 	template<typename BeginIt, typename EndIt, typename... Args>
 	format_it & format(BeginIt begin, EndIt end, const Args &... args)
 	{
 		DefaultInitializedBool did_use_argument[sizeof...(Args)];
+		detail::format_arguments<C, It, Args...> arguments(args...);
 		while (begin != end)
 		{
 			if (*begin == C('%'))
@@ -172,7 +370,7 @@ struct format_it : std::iterator<std::output_iterator_tag, void, void, void, voi
 						i *= 10;
 						i += to_digit(*begin);
 					}
-					index_format(i, args...);
+					arguments.format(*this, i);
 					did_use_argument[i].b = true;
 				}
 				else if (*begin == C('%'))
@@ -187,8 +385,12 @@ struct format_it : std::iterator<std::output_iterator_tag, void, void, void, voi
 			}
 			else
 			{
-				*this = *begin;
-				++begin;
+				BeginIt literal_end = begin;
+				for (++literal_end; literal_end != end && *literal_end != C('%'); ++literal_end)
+				{
+				}
+				write_literal(begin, literal_end);
+				begin = literal_end;
 			}
 		}
 		if (!std::all_of(did_use_argument, did_use_argument + sizeof...(Args), [](DefaultInitializedBool b){ return b.b; }))
@@ -246,15 +448,14 @@ struct format_it : std::iterator<std::output_iterator_tag, void, void, void, voi
 private:
 	It _it;
 
-	void index_format(int)
+	void write_literal(const C * begin, const C * end)
 	{
-		throw format_error(format_error::FormatIndexOutOfRange);
+		write(begin, end);
 	}
-	template<typename First, typename... Args>
-	void index_format(int i, const First & first, const Args &... args)
+	template<typename BeginIt>
+	void write_literal(BeginIt begin, BeginIt end)
 	{
-		if (i == 0) *this = first;
-		else index_format(i - 1, args...);
+		*this = std::copy(begin, end, *this);
 	}
 	static bool is_digit(C c)
 	{
@@ -275,11 +476,33 @@ format_it<C, It> make_format_it(It it)
 	return { std::move(it) };
 }
 
+namespace detail
+{
+// types without a format() overload or formatter specialization go through a
+// std::ostream, which is a lot slower than the native formatters. define
+// FORMAT_WARN_OSTREAM_FALLBACK to get a warning for every type that does
+// that, or FORMAT_NO_OSTREAM_FALLBACK to make it an error. the type is in
+// the "required from" lines of the diagnostic
+template<typename T>
+struct ostream_fallback
+{
+#if defined(FORMAT_NO_OSTREAM_FALLBACK)
+	static_assert(sizeof(T) == 0, "This type would be formatted using operator<<. Provide a format(format_it<C, It>, T) overload instead");
+#endif
+#if defined(FORMAT_WARN_OSTREAM_FALLBACK)
+	[[deprecated("this type is formatted using operator<<")]]
+#endif
+	static void used()
+	{
+	}
+};
+}
 template<typename T, typename C, typename It, typename Enable>
 struct formatter
 {
 	format_it<C, It> operator()(format_it<C, It> it, const T & value) const
 	{
+		detail::ostream_fallback<T>::used();
 		static thread_local detail::iterator_streambuf<C, format_it<C, It> > buf(it);
 		static thread_local std::basic_ostream<C> stream(&buf);
 		buf.it = it;
@@ -290,23 +513,38 @@ struct formatter
 template<typename T, typename A, typename C, typename It>
 format_it<C, It> format(format_it<C, It> it, const std::basic_string<C, T, A> & string)
 {
-	return std::copy(string.begin(), string.end(), it);
+	return it.write(string.data(), string.data() + string.size());
 }
 template<typename C, typename It, size_t Size>
 format_it<C, It> format(format_it<C, It> it, const C (&string)[Size])
 {
-	return std::copy(string, string + Size - 1, it);
+	return it.write(string, string + Size - 1);
+}
+#ifdef FORMAT_STRING_VIEW
+template<typename T, typename C, typename It>
+format_it<C, It> format(format_it<C, It> it, std::basic_string_view<C, T> string)
+{
+	return it.write(string.data(), string.data() + string.size());
 }
+#endif
+template<typename C, typename It>
+struct formatter<std::nullptr_t, C, It>
+{
+	format_it<C, It> operator()(format_it<C, It> it, std::nullptr_t) const
+	{
+		return it.print("nullptr");
+	}
+};
+template<>
+struct max_formatted_size<std::nullptr_t> : std::integral_constant<size_t, 7>
+{
+};
 template<typename C, typename It>
 struct formatter<const C *, C, It>
 {
 	format_it<C, It> operator()(format_it<C, It> it, const C * string) const
 	{
-		while (*string)
-		{
-			*it++ = *string++;
-		}
-		return it;
+		return it.write(string, string + std::char_traits<C>::length(string));
 	}
 };
 template<typename C, typename It>
@@ -326,11 +564,7 @@ struct formatter<const char *, char, It>
 {
 	format_it<char, It> operator()(format_it<char, It> it, const char * string) const
 	{
-		while (*string)
-		{
-			*it++ = *string++;
-		}
-		return it;
+		return it.write(string, string + std::char_traits<char>::length(string));
 	}
 };
 template<typename C, size_t Size, typename It>
@@ -338,7 +572,7 @@ struct formatter<C[Size], C, It>
 {
 	format_it<C, It> operator()(format_it<C, It> it, const C (&string)[Size]) const
 	{
-		return std::copy(string, string + Size - 1, it);
+		return it.write(string, string + Size - 1);
 	}
 };
 template<size_t Size, typename C, typename It>
@@ -354,9 +588,24 @@ struct formatter<char[Size], char, It>
 {
 	format_it<char, It> operator()(format_it<char, It> it, const char (&string)[Size]) const
 	{
-		return std::copy(string, string + Size - 1, it);
+		return it.write(string, string + Size - 1);
 	}
 };
+namespace detail
+{
+// the integer and float formatters produce their digits as chars. this
+// writes them in bulk if the output is also char
+template<typename C, typename It>
+format_it<C, It> write_chars(format_it<C, It> it, const char * begin, const char * end)
+{
+	return std::copy(begin, end, it);
+}
+template<typename It>
+format_it<char, It> write_chars(format_it<char, It> it, const char * begin, const char * end)
+{
+	return it.write(begin, end);
+}
+}
 }
 
 #include "format_integers.hpp"
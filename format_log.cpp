@@ -0,0 +1,305 @@
+/*
+This is free and unencumbered software released into the public domain.
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+For more information, please refer to <http://unlicense.org/>
+*/
+
+#include "format_log.hpp"
+#include <chrono>
+
+namespace fmt
+{
+constexpr size_t async_logger::default_ring_size;
+
+namespace
+{
+std::atomic<size_t> next_logger_id{0};
+// the rings of the current thread, by logger id. a thread keeps its rings
+// until it exits or until their logger is destroyed
+struct thread_rings
+{
+	~thread_rings()
+	{
+		for (auto & ring : rings) ring.second->abandoned.store(true, std::memory_order_release);
+	}
+	std::vector<std::pair<size_t, std::shared_ptr<detail::log_ring> > > rings;
+};
+thread_local thread_rings this_thread_rings;
+size_t round_up_to_power_of_two(size_t size)
+{
+	size_t result = detail::log_record_alignment;
+	while (result < size) result *= 2;
+	return result;
+}
+}
+
+async_logger::async_logger(int fd, log_overflow overflow, size_t ring_size)
+	: writer(fd), overflow(overflow), ring_size(round_up_to_power_of_two(ring_size)), id(next_logger_id.fetch_add(1, std::memory_order_relaxed))
+{
+	thread = std::thread([this]{ run(); });
+}
+async_logger::~async_logger()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stop = true;
+	}
+	wake_up.notify_one();
+	thread.join();
+	// the threads that wrote into this logger drop their rings the next time
+	// they log anything
+	for (const std::shared_ptr<detail::log_ring> & ring : rings) ring->orphaned.store(true, std::memory_order_relaxed);
+}
+void async_logger::flush()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	size_t request = ++flush_requested;
+	wake_up.notify_one();
+	flushed.wait(lock, [&]{ return flush_done >= request; });
+}
+detail::log_ring & async_logger::thread_ring()
+{
+	std::vector<std::pair<size_t, std::shared_ptr<detail::log_ring> > > & thread_rings = this_thread_rings.rings;
+	thread_rings.erase(std::remove_if(thread_rings.begin(), thread_rings.end(), [](const std::pair<size_t, std::shared_ptr<detail::log_ring> > & ring)
+	{
+		return ring.second->orphaned.load(std::memory_order_relaxed);
+	}), thread_rings.end());
+	for (auto & ring : thread_rings)
+	{
+		if (ring.first == id) return *ring.second;
+	}
+	std::shared_ptr<detail::log_ring> ring = std::make_shared<detail::log_ring>(ring_size);
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		rings.push_back(ring);
+	}
+	thread_rings.emplace_back(id, ring);
+	return *ring;
+}
+char * async_logger::reserve(detail::log_ring & ring, size_t size)
+{
+	char * out = size <= ring.capacity ? ring.reserve(size) : nullptr;
+	if (!out && overflow == log_overflow::block && size <= ring.capacity)
+	{
+		do
+		{
+			wake_up.notify_one();
+			std::this_thread::yield();
+		}
+		while (!(out = ring.reserve(size)));
+	}
+	if (!out) num_dropped.fetch_add(1, std::memory_order_relaxed);
+	return out;
+}
+void async_logger::write_record(const detail::log_record_header & header)
+{
+	format_it<char, fd_sink> it(writer.sink());
+	try
+	{
+		header.format(it, header.format_begin, header.format_end, header.arguments());
+	}
+	catch (const format_error & error)
+	{
+		it.format("\nformat error in log record \"%0\": %1\n", detail::log_string{ header.format_begin, size_t(header.format_end - header.format_begin) }, error.what());
+	}
+}
+bool async_logger::drain_rings()
+{
+	std::vector<std::shared_ptr<detail::log_ring> > current;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		// the rings of threads that exited can go once they're empty
+		rings.erase(std::remove_if(rings.begin(), rings.end(), [](const std::shared_ptr<detail::log_ring> & ring)
+		{
+			return ring->abandoned.load(std::memory_order_acquire) && ring->tail.load(std::memory_order_relaxed) == ring->head.load(std::memory_order_acquire);
+		}), rings.end());
+		current = rings;
+	}
+	bool wrote = false;
+	for (const std::shared_ptr<detail::log_ring> & ring : current)
+	{
+		size_t end = ring->head.load(std::memory_order_acquire);
+		if (end == ring->tail.load(std::memory_order_relaxed)) continue;
+		ring->consume(end, [this](const detail::log_record_header & header){ write_record(header); });
+		wrote = true;
+	}
+	size_t dropped = num_dropped.load(std::memory_order_relaxed);
+	if (overflow == log_overflow::count_dropped && dropped != num_dropped_reported)
+	{
+		make_format_it(writer.sink()).format("%0 log records dropped\n", dropped - num_dropped_reported);
+		num_dropped_reported = dropped;
+		wrote = true;
+	}
+	return wrote;
+}
+void async_logger::run()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	for (;;)
+	{
+		bool stopping = stop;
+		size_t flush_request = flush_requested;
+		lock.unlock();
+		// the heads get loaded after flush_requested, so this pass gets
+		// everything that was logged before the flush() call
+		bool wrote = drain_rings();
+		if (!wrote || flush_request != flush_done || stopping) writer.flush();
+		lock.lock();
+		if (flush_request != flush_done)
+		{
+			flush_done = flush_request;
+			flushed.notify_all();
+		}
+		if (stopping) return;
+		else if (!wrote && !stop && flush_requested == flush_done) wake_up.wait_for(lock, std::chrono::milliseconds(1));
+	}
+}
+}
+
+#ifndef DISABLE_GTEST
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <sstream>
+#include <unistd.h>
+namespace
+{
+struct temporary_file
+{
+	temporary_file()
+		: file(std::tmpfile())
+	{
+	}
+	~temporary_file()
+	{
+		std::fclose(file);
+	}
+	int fd() const
+	{
+		return fileno(file);
+	}
+	std::string contents() const
+	{
+		std::string result(size_t(lseek(fd(), 0, SEEK_END)), '\0');
+		ssize_t num_read = pread(fd(), &result[0], result.size(), 0);
+		result.resize(num_read < 0 ? 0 : size_t(num_read));
+		return result;
+	}
+	FILE * file;
+};
+enum class log_level
+{
+	info = 2,
+};
+struct formatted_eagerly
+{
+	int value;
+};
+template<typename C, typename It>
+fmt::format_it<C, It> format(fmt::format_it<C, It> it, const formatted_eagerly & value)
+{
+	return it.printpacked('<', value.value, '>');
+}
+TEST(format_log, arguments)
+{
+	temporary_file file;
+	fmt::async_logger log(file.fd());
+	const char * pointer = "pointer";
+	char buffer[] = "buffer";
+	log.format("%0 %1 %2 %3 %4\n", 1, -2.5, 'c', true, log_level::info);
+	log.format("%0 %1 %2 %3\n", std::string(100, 's'), pointer, buffer, "literal");
+	log.format("%0 %1\n", formatted_eagerly{ 7 }, nullptr);
+	log.format("no arguments\n");
+	log.flush();
+	ASSERT_EQ("1 -2.5 c 1 2\n" + std::string(100, 's') + " pointer buffer literal\n<7> nullptr\nno arguments\n", file.contents());
+}
+TEST(format_log, threads)
+{
+	temporary_file file;
+	{
+		fmt::async_logger log(file.fd(), fmt::log_overflow::block, 256);
+		std::vector<std::thread> threads;
+		for (int i = 0; i < 4; ++i)
+		{
+			threads.emplace_back([&log, i]
+			{
+				for (int j = 0; j < 1000; ++j) log.format("%0 %1\n", i, j);
+			});
+		}
+		for (std::thread & thread : threads) thread.join();
+	}
+	std::istringstream lines(file.contents());
+	int next[4] = {};
+	for (int thread, line; lines >> thread >> line;)
+	{
+		ASSERT_EQ(next[thread]++, line);
+	}
+	for (int count : next) ASSERT_EQ(1000, count);
+}
+TEST(format_log, dropped)
+{
+	temporary_file file;
+	fmt::async_logger log(file.fd(), fmt::log_overflow::count_dropped, 64);
+	log.format("%0\n", std::string(100, 'x'));
+	log.format("short\n");
+	log.flush();
+	ASSERT_EQ(1u, log.dropped());
+	ASSERT_EQ("short\n1 log records dropped\n", file.contents());
+}
+TEST(format_log, larger_than_ring)
+{
+	temporary_file file;
+	std::string large(5000, 'x');
+	{
+		fmt::async_logger log(file.fd(), fmt::log_overflow::block, 1024);
+		log.format("%0\n", large);
+		log.format("after\n");
+		log.flush();
+		ASSERT_EQ(0u, log.dropped());
+	}
+	ASSERT_EQ(large + "\nafter\n", file.contents());
+}
+TEST(format_log, rings_of_destroyed_loggers)
+{
+	temporary_file file;
+	std::thread([&file]
+	{
+		for (int i = 0; i < 10; ++i)
+		{
+			fmt::async_logger log(file.fd());
+			log.format("%0\n", i);
+			log.flush();
+			ASSERT_EQ(1u, fmt::this_thread_rings.rings.size());
+		}
+	}).join();
+	ASSERT_EQ("0\n1\n2\n3\n4\n5\n6\n7\n8\n9\n", file.contents());
+}
+TEST(format_log, format_error)
+{
+	temporary_file file;
+	fmt::async_logger log(file.fd());
+	log.format("%0 %\n", 5);
+	log.format("next\n");
+	log.flush();
+	std::string contents = file.contents();
+	ASSERT_NE(std::string::npos, contents.find("format error in log record \"%0 %\n\""));
+	ASSERT_EQ("next\n", contents.substr(contents.size() - 5));
+}
+}
+#endif
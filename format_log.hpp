@@ -0,0 +1,414 @@
+/*
+This is free and unencumbered software released into the public domain.
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+For more information, please refer to <http://unlicense.org/>
+*/
+
+#pragma once
+
+#include "format_fd.hpp"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+// a logger that formats on a background thread:
+// fmt::async_logger log(fd);
+// log.format("%0 %1 took %2ms\n", method, url, duration);
+// the calling thread only copies the arguments into a ring buffer that
+// belongs to that thread. the background thread takes them out again and
+// runs format_it::format into an fd_writer. numbers, enums, void pointers
+// and strings are copied as they are. all other types get formatted into a
+// string on the calling thread. the format string has to stay alive for as
+// long as the logger, so use string literals.
+// records from one thread come out in order, but records from different
+// threads can come out in any order. format errors can't be thrown at the
+// call site, so they get written to the log instead.
+// when a ring is full, log_overflow says what happens: block waits for the
+// background thread, drop throws the record away, and count_dropped also
+// throws it away but writes how many records were lost into the log once
+// there is space again. dropped() counts the records lost in both modes.
+// in block mode a record that is bigger than the whole ring gets copied
+// into its own heap allocation instead, and only a pointer goes into the
+// ring.
+// flush() waits until everything that the calling thread logged before is
+// written to the file descriptor
+namespace fmt
+{
+enum class log_overflow
+{
+	block,
+	drop,
+	count_dropped,
+};
+namespace detail
+{
+typedef void (*log_format_function)(format_it<char, fd_sink> & it, const char * format_begin, const char * format_end, const char * arguments);
+// records are aligned to this. it's also the smallest record so that padding
+// at the end of the ring always has space for a header
+static constexpr size_t log_record_alignment = 16;
+struct log_record_header
+{
+	// includes the header and the padding after the arguments. a record with
+	// no format function is padding at the end of the ring
+	size_t size;
+	log_format_function format;
+	const char * format_begin;
+	const char * format_end;
+
+	const char * arguments() const
+	{
+		return reinterpret_cast<const char *>(this + 1);
+	}
+};
+static_assert(sizeof(log_record_header) % log_record_alignment == 0, "the arguments have to start aligned");
+
+// single producer, single consumer. the positions only ever grow, the index
+// into data is the position modulo capacity
+struct log_ring
+{
+	explicit log_ring(size_t capacity)
+		: data(new char[capacity]), capacity(capacity)
+	{
+	}
+	// returns space for size bytes or nullptr if the ring is full. size has to
+	// be a multiple of log_record_alignment
+	char * reserve(size_t size)
+	{
+		size_t position = head.load(std::memory_order_relaxed);
+		size_t offset = position & (capacity - 1);
+		size_t padding = offset + size > capacity ? capacity - offset : 0;
+		if (position + padding + size - cached_tail > capacity)
+		{
+			cached_tail = tail.load(std::memory_order_acquire);
+			if (position + padding + size - cached_tail > capacity) return nullptr;
+		}
+		if (padding)
+		{
+			log_record_header * header = reinterpret_cast<log_record_header *>(data.get() + offset);
+			header->size = padding;
+			header->format = nullptr;
+			reserved_padding = padding;
+			return data.get();
+		}
+		reserved_padding = 0;
+		return data.get() + offset;
+	}
+	void commit(size_t size)
+	{
+		head.store(head.load(std::memory_order_relaxed) + reserved_padding + size, std::memory_order_release);
+	}
+	// calls f with every record up to the position end
+	template<typename F>
+	void consume(size_t end, F && f)
+	{
+		size_t position = tail.load(std::memory_order_relaxed);
+		while (position != end)
+		{
+			const log_record_header * header = reinterpret_cast<const log_record_header *>(data.get() + (position & (capacity - 1)));
+			if (header->format) f(*header);
+			position += header->size;
+			tail.store(position, std::memory_order_release);
+		}
+	}
+
+	std::unique_ptr<char[]> data;
+	size_t capacity;
+	// only used by the producer
+	size_t cached_tail = 0;
+	size_t reserved_padding = 0;
+	// set when the thread that writes into this ring exits
+	std::atomic<bool> abandoned{false};
+	// set when the logger that reads from this ring is destroyed
+	std::atomic<bool> orphaned{false};
+	alignas(64) std::atomic<size_t> head{0};
+	alignas(64) std::atomic<size_t> tail{0};
+};
+
+struct log_string
+{
+	const char * data;
+	size_t size;
+};
+template<typename C, typename It>
+format_it<C, It> format(format_it<C, It> it, log_string string)
+{
+	return detail::write_chars(it, string.data, string.data + string.size);
+}
+// strings get copied without formatting them first. the length goes in front
+struct log_string_argument
+{
+	typedef log_string captured;
+	static size_t size(const captured & value)
+	{
+		return sizeof(size_t) + value.size;
+	}
+	static char * encode(char * out, const captured & value)
+	{
+		std::memcpy(out, &value.size, sizeof(size_t));
+		std::memcpy(out + sizeof(size_t), value.data, value.size);
+		return out + sizeof(size_t) + value.size;
+	}
+	static log_string decode(const char *& in)
+	{
+		log_string result;
+		std::memcpy(&result.size, in, sizeof(size_t));
+		result.data = in + sizeof(size_t);
+		in += sizeof(size_t) + result.size;
+		return result;
+	}
+};
+// how an argument gets into the ring. capture runs on the calling thread and
+// turns the argument into something that can be measured and copied. encode
+// copies that into the ring and decode gets it back out on the background
+// thread. types that aren't handled below get formatted into a string
+template<typename T, typename Enable = void>
+struct log_argument
+{
+	typedef std::string captured;
+	static captured capture(const T & value)
+	{
+		std::string result;
+		make_format_it(std::back_inserter(result)) = value;
+		return result;
+	}
+	static size_t size(const captured & value)
+	{
+		return log_string_argument::size({ value.data(), value.size() });
+	}
+	static char * encode(char * out, const captured & value)
+	{
+		return log_string_argument::encode(out, { value.data(), value.size() });
+	}
+	static log_string decode(const char *& in)
+	{
+		return log_string_argument::decode(in);
+	}
+};
+template<typename T>
+struct log_argument<T, typename std::enable_if<std::is_arithmetic<T>::value || std::is_enum<T>::value || std::is_same<T, const void *>::value || std::is_same<T, void *>::value || std::is_same<T, std::nullptr_t>::value>::type>
+{
+	typedef T captured;
+	static captured capture(const T & value)
+	{
+		return value;
+	}
+	static size_t size(const captured &)
+	{
+		return sizeof(T);
+	}
+	static char * encode(char * out, const captured & value)
+	{
+		std::memcpy(out, &value, sizeof(T));
+		return out + sizeof(T);
+	}
+	static T decode(const char *& in)
+	{
+		T result;
+		std::memcpy(&result, in, sizeof(T));
+		in += sizeof(T);
+		return result;
+	}
+};
+template<typename Traits, typename Allocator>
+struct log_argument<std::basic_string<char, Traits, Allocator> > : log_string_argument
+{
+	static captured capture(const std::basic_string<char, Traits, Allocator> & value)
+	{
+		return { value.data(), value.size() };
+	}
+};
+template<>
+struct log_argument<const char *> : log_string_argument
+{
+	static captured capture(const char * value)
+	{
+		return { value, std::char_traits<char>::length(value) };
+	}
+};
+template<>
+struct log_argument<char *> : log_argument<const char *>
+{
+};
+template<size_t Size>
+struct log_argument<char[Size]> : log_string_argument
+{
+	static captured capture(const char (&value)[Size])
+	{
+		return { value, Size - 1 };
+	}
+};
+#ifdef FORMAT_STRING_VIEW
+template<typename Traits>
+struct log_argument<std::basic_string_view<char, Traits> > : log_string_argument
+{
+	static captured capture(std::basic_string_view<char, Traits> value)
+	{
+		return { value.data(), value.size() };
+	}
+};
+#endif
+
+// a record that is bigger than the whole ring. it lives in a block on the
+// heap and the ring only holds a pointer to that, which gets freed after
+// the record was formatted
+struct log_heap_record
+{
+	static constexpr size_t size = sizeof(log_record_header) + log_record_alignment;
+
+	static void format(format_it<char, fd_sink> & it, const char *, const char *, const char * arguments)
+	{
+		char * block;
+		std::memcpy(&block, arguments, sizeof(block));
+		std::unique_ptr<char[]> owner(block);
+		const log_record_header * header = reinterpret_cast<const log_record_header *>(block);
+		header->format(it, header->format_begin, header->format_end, header->arguments());
+	}
+};
+
+template<typename... Args>
+struct log_record
+{
+	static size_t size(const typename log_argument<Args>::captured &... captured)
+	{
+		size_t sizes[] = { sizeof(log_record_header), log_argument<Args>::size(captured)... };
+		size_t result = 0;
+		for (size_t size : sizes) result += size;
+		return (result + log_record_alignment - 1) / log_record_alignment * log_record_alignment;
+	}
+	static void encode(char * out, const typename log_argument<Args>::captured &... captured)
+	{
+		char * expand[] = { out, (out = log_argument<Args>::encode(out, captured))... };
+		static_cast<void>(expand);
+	}
+	static void format(format_it<char, fd_sink> & it, const char * format_begin, const char * format_end, const char * arguments)
+	{
+		// braced initialization decodes the arguments from left to right
+		std::tuple<decltype(log_argument<Args>::decode(arguments))...> decoded{ log_argument<Args>::decode(arguments)... };
+		format_tuple(it, format_begin, format_end, decoded, std::index_sequence_for<Args...>());
+	}
+	template<typename Tuple, size_t... Indices>
+	static void format_tuple(format_it<char, fd_sink> & it, const char * format_begin, const char * format_end, const Tuple & decoded, std::index_sequence<Indices...>)
+	{
+		it.format(format_begin, format_end, std::get<Indices>(decoded)...);
+	}
+};
+}
+struct async_logger
+{
+	static constexpr size_t default_ring_size = 64 * 1024;
+
+	// ring_size is per thread and gets rounded up to a power of two
+	explicit async_logger(int fd, log_overflow overflow = log_overflow::block, size_t ring_size = default_ring_size);
+	// writes everything that's still in the rings
+	~async_logger();
+	async_logger(const async_logger &) = delete;
+	async_logger & operator=(const async_logger &) = delete;
+
+	template<size_t FormatSize, typename... Args>
+	void format(const char (&format_string)[FormatSize], const Args &... args)
+	{
+		log(format_string, format_string + FormatSize - 1, log_argument_capture<Args>(args)...);
+	}
+	void flush();
+	size_t dropped() const
+	{
+		return num_dropped.load(std::memory_order_relaxed);
+	}
+	// errno of the first write that failed, see fd_writer
+	int error() const
+	{
+		return writer.error();
+	}
+
+private:
+	template<typename T>
+	struct log_argument_capture
+	{
+		typedef T type;
+		log_argument_capture(const T & value)
+			: captured(detail::log_argument<T>::capture(value))
+		{
+		}
+		typename detail::log_argument<T>::captured captured;
+	};
+	template<typename... Args>
+	void log(const char * format_begin, const char * format_end, const log_argument_capture<Args> &... args)
+	{
+		typedef detail::log_record<Args...> record;
+		size_t size = record::size(args.captured...);
+		detail::log_ring & ring = thread_ring();
+		if (size > ring.capacity && overflow == log_overflow::block)
+		{
+			std::unique_ptr<char[]> block(new char[size]);
+			write_header(block.get(), size, &record::format, format_begin, format_end);
+			record::encode(block.get() + sizeof(detail::log_record_header), args.captured...);
+			char * out = reserve(ring, detail::log_heap_record::size);
+			if (!out) return;
+			write_header(out, detail::log_heap_record::size, &detail::log_heap_record::format, format_begin, format_end);
+			char * pointer = block.release();
+			std::memcpy(out + sizeof(detail::log_record_header), &pointer, sizeof(pointer));
+			ring.commit(detail::log_heap_record::size);
+			return;
+		}
+		char * out = reserve(ring, size);
+		if (!out) return;
+		write_header(out, size, &record::format, format_begin, format_end);
+		record::encode(out + sizeof(detail::log_record_header), args.captured...);
+		ring.commit(size);
+	}
+	static void write_header(char * out, size_t size, detail::log_format_function format, const char * format_begin, const char * format_end)
+	{
+		detail::log_record_header * header = reinterpret_cast<detail::log_record_header *>(out);
+		header->size = size;
+		header->format = format;
+		header->format_begin = format_begin;
+		header->format_end = format_end;
+	}
+	char * reserve(detail::log_ring & ring, size_t size);
+	detail::log_ring & thread_ring();
+	void run();
+	// writes everything that's in the rings right now. returns false if
+	// there was nothing
+	bool drain_rings();
+	void write_record(const detail::log_record_header & header);
+
+	fd_writer writer;
+	log_overflow overflow;
+	size_t ring_size;
+	size_t id;
+	std::atomic<size_t> num_dropped{0};
+	size_t num_dropped_reported = 0;
+	std::mutex mutex;
+	std::condition_variable wake_up;
+	std::condition_variable flushed;
+	std::vector<std::shared_ptr<detail::log_ring> > rings;
+	size_t flush_requested = 0;
+	size_t flush_done = 0;
+	bool stop = false;
+	std::thread thread;
+};
+}
@@ -0,0 +1,206 @@
+/*
+This is free and unencumbered software released into the public domain.
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+For more information, please refer to <http://unlicense.org/>
+*/
+
+#include "format_mmap.hpp"
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace fmt
+{
+constexpr size_t mmap_file::default_chunk_size;
+
+mmap_file::mmap_file(const char * path, size_t chunk_size)
+	: fd(::open(path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0666)), chunk_size(chunk_size ? chunk_size : default_chunk_size)
+{
+	if (fd < 0) _error = errno;
+}
+mmap_file::~mmap_file()
+{
+	close();
+}
+bool mmap_file::grow(size_t size)
+{
+	if (_error) return false;
+	size_t old_capacity = data ? capacity : 0;
+	size_t new_capacity = (_size + size + chunk_size - 1) / chunk_size * chunk_size;
+#ifdef __APPLE__
+	// there is no posix_fallocate. the file stays sparse, so running out of
+	// disk space is a SIGBUS when writing to the mapping
+	int result = ::ftruncate(fd, off_t(new_capacity)) != 0 ? errno : 0;
+#else
+	// allocate the blocks of the new chunk up front so that running out of
+	// disk space is an error here instead of a SIGBUS while formatting
+	int result;
+	do result = ::posix_fallocate(fd, off_t(old_capacity), off_t(new_capacity - old_capacity));
+	while (result == EINTR);
+#endif
+	if (result != 0) return fail(result);
+	void * mapped;
+	if (!data) mapped = ::mmap(nullptr, new_capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	else
+	{
+#ifdef __linux__
+		mapped = ::mremap(data, capacity, new_capacity, MREMAP_MAYMOVE);
+#else
+		::munmap(data, capacity);
+		data = nullptr;
+		mapped = ::mmap(nullptr, new_capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+#endif
+	}
+	// mremap leaves the old mapping alone when it fails, fail() unmaps it
+	if (mapped == MAP_FAILED) return fail(errno);
+	data = static_cast<char *>(mapped);
+	capacity = new_capacity;
+	::madvise(data, capacity, MADV_SEQUENTIAL);
+#ifdef MADV_POPULATE_WRITE
+	// fault in the new pages all at once instead of one at a time while
+	// formatting. this is only a hint, older kernels ignore it
+	::madvise(data + old_capacity, capacity - old_capacity, MADV_POPULATE_WRITE);
+#endif
+	return true;
+}
+bool mmap_file::fail(int error)
+{
+	_error = error;
+	if (data) ::munmap(data, capacity);
+	data = nullptr;
+	// the sinks only check capacity, so this makes every following write go
+	// through grow() which drops it because of the error
+	capacity = _size;
+	return false;
+}
+void mmap_file::close()
+{
+	if (fd < 0) return;
+	if (data) ::munmap(data, capacity);
+	if (::ftruncate(fd, off_t(_size)) != 0 && !_error) _error = errno;
+	::close(fd);
+	fd = -1;
+	data = nullptr;
+	capacity = _size;
+}
+}
+
+#ifndef DISABLE_GTEST
+#include <gtest/gtest.h>
+#include "stack_format.hpp"
+#include <sys/resource.h>
+#include <csignal>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+namespace
+{
+struct temporary_path
+{
+	temporary_path()
+	{
+		int fd = mkstemp(path);
+		if (fd >= 0) ::close(fd);
+	}
+	~temporary_path()
+	{
+		::unlink(path);
+	}
+	std::string contents() const
+	{
+		std::ifstream file(path, std::ios::binary);
+		std::ostringstream result;
+		result << file.rdbuf();
+		return result.str();
+	}
+	char path[32] = "/tmp/format_mmap_XXXXXX";
+};
+TEST(format_mmap, grows_and_truncates)
+{
+	temporary_path path;
+	std::string expected;
+	{
+		fmt::mmap_file file(path.path, 4096);
+		auto it = fmt::make_format_it(file.sink());
+		for (int i = 0; i < 10000; ++i)
+		{
+			it.format("%0,%1\n", i, i * 0.25);
+			expected += std::to_string(i) + ',' + fmt::stack_print<64>(i * 0.25).c_str() + '\n';
+		}
+		std::string large(10000, 'x');
+		it.printpacked(large, '\n');
+		expected += large + '\n';
+		ASSERT_EQ(expected.size(), file.size());
+		ASSERT_EQ(0, file.error());
+	}
+	ASSERT_EQ(expected, path.contents());
+}
+TEST(format_mmap, empty)
+{
+	temporary_path path;
+	fmt::mmap_file file(path.path);
+	file.close();
+	ASSERT_EQ(0, file.error());
+	ASSERT_EQ("", path.contents());
+}
+TEST(format_mmap, file_size_limit)
+{
+	// running out of space when growing the file has to drop the output
+	// instead of writing through a mapping that isn't there
+	temporary_path path;
+	rlimit old_limit;
+	ASSERT_EQ(0, ::getrlimit(RLIMIT_FSIZE, &old_limit));
+	rlimit limit = old_limit;
+	limit.rlim_cur = 3 * 4096;
+	ASSERT_EQ(0, ::setrlimit(RLIMIT_FSIZE, &limit));
+	void (*old_handler)(int) = std::signal(SIGXFSZ, SIG_IGN);
+	std::string expected;
+	size_t size;
+	{
+		fmt::mmap_file file(path.path, 4096);
+		auto it = fmt::make_format_it(file.sink());
+		for (int i = 0; i < 10000; ++i)
+		{
+			it.format("%0,%1\n", i, i * 0.25);
+			expected += std::to_string(i) + ',' + fmt::stack_print<64>(i * 0.25).c_str() + '\n';
+		}
+		size = file.size();
+		it = 'x';
+		it.printpacked(std::string(10000, 'x'));
+		it.format("%0", 1.5);
+		ASSERT_EQ(EFBIG, file.error());
+		ASSERT_EQ(size, file.size());
+	}
+	std::signal(SIGXFSZ, old_handler);
+	ASSERT_EQ(0, ::setrlimit(RLIMIT_FSIZE, &old_limit));
+	ASSERT_LE(size, 3u * 4096);
+	ASSERT_EQ(expected.substr(0, size), path.contents());
+}
+TEST(format_mmap, error)
+{
+	fmt::mmap_file file("/nonexistent/directory/file");
+	fmt::make_format_it(file.sink()).print("dropped", 5);
+	ASSERT_EQ(ENOENT, file.error());
+	ASSERT_EQ(0u, file.size());
+}
+}
+#endif
@@ -0,0 +1,129 @@
+/*
+This is free and unencumbered software released into the public domain.
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+For more information, please refer to <http://unlicense.org/>
+*/
+
+#pragma once
+
+#include "format_it.hpp"
+#include <iterator>
+#include <cstring>
+
+// formats straight into a memory mapped file, for writing large files
+// without a copy into a buffer and without a syscall per write:
+// fmt::mmap_file file("export.csv");
+// auto it = fmt::make_format_it(file.sink());
+// for (const row & r : rows) it.format("%0,%1\n", r.id, r.value);
+// file.close();
+// the file grows in steps of chunk_size with posix_fallocate and mremap and
+// gets truncated to what was written on close(), which the destructor also
+// calls. the file gets created or truncated when it's opened. if anything
+// fails, including running out of disk space, error() returns its errno and
+// all output after that is dropped
+namespace fmt
+{
+struct mmap_file_sink;
+struct mmap_file
+{
+	static constexpr size_t default_chunk_size = 64 * 1024 * 1024;
+
+	explicit mmap_file(const char * path, size_t chunk_size = default_chunk_size);
+	~mmap_file();
+	mmap_file(const mmap_file &) = delete;
+	mmap_file & operator=(const mmap_file &) = delete;
+
+	mmap_file_sink sink();
+	void close();
+	// the number of bytes written so far
+	size_t size() const
+	{
+		return _size;
+	}
+	int error() const
+	{
+		return _error;
+	}
+
+private:
+	friend struct mmap_file_sink;
+	// makes space for at least size more bytes. returns false on failure
+	bool grow(size_t size);
+	// remembers the error and drops the mapping. returns false
+	bool fail(int error);
+
+	int fd = -1;
+	int _error = 0;
+	char * data = nullptr;
+	size_t _size = 0;
+	size_t capacity = 0;
+	size_t chunk_size;
+};
+struct mmap_file_sink : std::iterator<std::output_iterator_tag, void, void, void, void>
+{
+	explicit mmap_file_sink(mmap_file & file)
+		: file(&file)
+	{
+	}
+	mmap_file_sink & operator=(char c)
+	{
+		if (file->_size != file->capacity || file->grow(1)) file->data[file->_size++] = c;
+		return *this;
+	}
+	void write(const char * begin, const char * end)
+	{
+		size_t size = end - begin;
+		if (size <= file->capacity - file->_size || file->grow(size))
+		{
+			std::memcpy(file->data + file->_size, begin, size);
+			file->_size += size;
+		}
+	}
+	// see detail::bounded_format
+	char * unchecked_begin(size_t size)
+	{
+		if (size <= file->capacity - file->_size || file->grow(size)) return file->data + file->_size;
+		else return nullptr;
+	}
+	void unchecked_end(char * end)
+	{
+		file->_size = end - file->data;
+	}
+	mmap_file_sink & operator*()
+	{
+		return *this;
+	}
+	mmap_file_sink & operator++()
+	{
+		return *this;
+	}
+	mmap_file_sink & operator++(int)
+	{
+		return *this;
+	}
+
+private:
+	mmap_file * file;
+};
+inline mmap_file_sink mmap_file::sink()
+{
+	return mmap_file_sink(*this);
+}
+}
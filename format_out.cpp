@@ -23,13 +23,168 @@ For more information, please refer to <http://unlicense.org/>
 
 #include "format_out.hpp"
 #include <iostream>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
 
 namespace fmt
 {
-format_it<char, std::ostreambuf_iterator<char> > cout{std::ostreambuf_iterator<char>(std::cout)};
-format_it<char, std::ostreambuf_iterator<char> > cerr{std::ostreambuf_iterator<char>(std::cerr)};
-format_it<char, std::ostreambuf_iterator<char> > clog{std::ostreambuf_iterator<char>(std::clog)};
-format_it<wchar_t, std::ostreambuf_iterator<wchar_t> > wcout{std::ostreambuf_iterator<wchar_t>(std::wcout)};
-format_it<wchar_t, std::ostreambuf_iterator<wchar_t> > wcerr{std::ostreambuf_iterator<wchar_t>(std::wcerr)};
-format_it<wchar_t, std::ostreambuf_iterator<wchar_t> > wclog{std::ostreambuf_iterator<wchar_t>(std::wclog)};
+namespace detail
+{
+static out_mode terminal_mode(int fd)
+{
+#ifdef _WIN32
+	return _isatty(fd) ? out_mode::line : out_mode::full;
+#else
+	return isatty(fd) ? out_mode::line : out_mode::full;
+#endif
+}
+// the destructors flush. cout_buffer comes first so that it's still around
+// when cerr_buffer and clog_buffer flush it
+static thread_local out_buffer<char> cout_buffer(std::cout, terminal_mode(1));
+static thread_local out_buffer<char> cerr_buffer(std::cerr, out_mode::line, &cout_buffer);
+static thread_local out_buffer<char> clog_buffer(std::clog, out_mode::full, &cout_buffer);
+static thread_local out_buffer<wchar_t> wcout_buffer(std::wcout, terminal_mode(1));
+static thread_local out_buffer<wchar_t> wcerr_buffer(std::wcerr, out_mode::line, &wcout_buffer);
+static thread_local out_buffer<wchar_t> wclog_buffer(std::wclog, out_mode::full, &wcout_buffer);
+}
+thread_local format_it<char, out_it<char> > cout{out_it<char>(detail::cout_buffer)};
+thread_local format_it<char, out_it<char> > cerr{out_it<char>(detail::cerr_buffer)};
+thread_local format_it<char, out_it<char> > clog{out_it<char>(detail::clog_buffer)};
+thread_local format_it<wchar_t, out_it<wchar_t> > wcout{out_it<wchar_t>(detail::wcout_buffer)};
+thread_local format_it<wchar_t, out_it<wchar_t> > wcerr{out_it<wchar_t>(detail::wcerr_buffer)};
+thread_local format_it<wchar_t, out_it<wchar_t> > wclog{out_it<wchar_t>(detail::wclog_buffer)};
+}
+
+#ifndef DISABLE_GTEST
+#include <gtest/gtest.h>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include <mutex>
+namespace
+{
+struct redirect
+{
+	redirect(std::ostream & stream, std::streambuf * buf)
+		: stream(stream), old(stream.rdbuf(buf))
+	{
+	}
+	~redirect()
+	{
+		stream.rdbuf(old);
+	}
+	std::ostream & stream;
+	std::streambuf * old;
+};
+TEST(format_out, full_buffer)
+{
+	std::ostringstream out;
+	redirect redirect_cout(std::cout, out.rdbuf());
+	fmt::out_mode old_mode = fmt::cout.it().mode();
+	fmt::cout.it().mode(fmt::out_mode::full);
+	fmt::cout.format("%0, %1\n", 1, "two");
+	ASSERT_EQ("", out.str());
+	fmt::flush(fmt::cout);
+	ASSERT_EQ("1, two\n", out.str());
+	// bigger than the buffer
+	std::string large(10000, 'a');
+	fmt::cout.print('b', large);
+	fmt::flush(fmt::cout);
+	ASSERT_EQ("1, two\nb " + large, out.str());
+	fmt::cout.it().mode(old_mode);
+}
+TEST(format_out, line_buffer)
+{
+	std::ostringstream out;
+	redirect redirect_cout(std::cout, out.rdbuf());
+	fmt::out_mode old_mode = fmt::cout.it().mode();
+	fmt::cout.it().mode(fmt::out_mode::line);
+	fmt::cout.print(1, 2);
+	ASSERT_EQ("", out.str());
+	*fmt::cout++ = '\n';
+	ASSERT_EQ("1 2\n", out.str());
+	fmt::cout.print("3\n4");
+	ASSERT_EQ("1 2\n3\n4", out.str());
+	fmt::cout.it().mode(old_mode);
+}
+// counts how often the buffered output gets handed on
+struct sync_counter : std::stringbuf
+{
+	int sync() override
+	{
+		++syncs;
+		return 0;
+	}
+	int syncs = 0;
+};
+TEST(format_out, line_buffer_large_write)
+{
+	sync_counter out;
+	redirect redirect_cout(std::cout, &out);
+	fmt::out_mode old_mode = fmt::cout.it().mode();
+	fmt::cout.it().mode(fmt::out_mode::line);
+	// bigger than the buffer, so it goes straight to the streambuf
+	std::string large(10000, 'a');
+	large.back() = '\n';
+	fmt::cout.print(large);
+	ASSERT_EQ(large, out.str());
+	ASSERT_LT(0, out.syncs);
+	fmt::cout.it().mode(old_mode);
+}
+TEST(format_out, cerr_flushes_cout)
+{
+	std::ostringstream out;
+	redirect redirect_cout(std::cout, out.rdbuf());
+	redirect redirect_cerr(std::cerr, out.rdbuf());
+	fmt::out_mode old_mode = fmt::cout.it().mode();
+	fmt::cout.it().mode(fmt::out_mode::full);
+	fmt::cout.print("first ");
+	fmt::cerr.print("second\n");
+	ASSERT_EQ("first second\n", out.str());
+	fmt::cout.it().mode(old_mode);
+}
+// std::stringbuf can't be written to from several threads
+struct locked_stringbuf : std::streambuf
+{
+	std::streamsize xsputn(const char * s, std::streamsize size) override
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		str.append(s, size);
+		return size;
+	}
+	int_type overflow(int_type ch) override
+	{
+		char c = traits_type::to_char_type(ch);
+		xsputn(&c, 1);
+		return ch;
+	}
+	std::mutex mutex;
+	std::string str;
+};
+TEST(format_out, threads_write_whole_lines)
+{
+	locked_stringbuf out;
+	redirect redirect_cout(std::cout, &out);
+	std::vector<std::thread> threads;
+	for (int i = 0; i < 4; ++i)
+	{
+		threads.emplace_back([i]
+		{
+			fmt::cout.it().mode(fmt::out_mode::line);
+			for (int j = 0; j < 100; ++j) fmt::cout.format("thread %0 line %1 %2\n", i, j, std::string(100, 'a' + i));
+		});
+	}
+	for (std::thread & thread : threads) thread.join();
+	std::istringstream lines(out.str);
+	int num_lines = 0;
+	for (std::string line; std::getline(lines, line); ++num_lines)
+	{
+		ASSERT_EQ(std::string(100, line[7] - '0' + 'a'), line.substr(line.size() - 100));
+	}
+	ASSERT_EQ(400, num_lines);
+}
 }
+#endif
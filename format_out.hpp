@@ -26,13 +26,174 @@ For more information, please refer to <http://unlicense.org/>
 #include "format_it.hpp"
 #include <ostream>
 #include <iterator>
+#include <memory>
+#include <cstring>
 
+// fmt::cout and friends collect output in a buffer per thread and hand it to
+// the std stream's streambuf with a single sputn. that way the records of
+// different threads don't get mixed up and formatting doesn't pay for a
+// virtual call per character. in out_mode::full the buffer only gets written
+// when it's full, when you call fmt::flush and when the thread exits. in
+// out_mode::line it also gets written at the end of every write that
+// contains a newline. fmt::cout is line buffered if stdout is a terminal,
+// fmt::cerr is always line buffered and fmt::clog is fully buffered.
+// like std::cerr and std::clog, fmt::cerr and fmt::clog flush fmt::cout
+// before they write anything
 namespace fmt
 {
-extern format_it<char, std::ostreambuf_iterator<char> > cout;
-extern format_it<char, std::ostreambuf_iterator<char> > cerr;
-extern format_it<char, std::ostreambuf_iterator<char> > clog;
-extern format_it<wchar_t, std::ostreambuf_iterator<wchar_t> > wcout;
-extern format_it<wchar_t, std::ostreambuf_iterator<wchar_t> > wcerr;
-extern format_it<wchar_t, std::ostreambuf_iterator<wchar_t> > wclog;
+enum class out_mode
+{
+	full,
+	line,
+};
+namespace detail
+{
+template<typename C>
+struct out_buffer
+{
+	static constexpr size_t buffer_size = 4096 / sizeof(C);
+
+	out_buffer(std::basic_ostream<C> & stream, out_mode mode, out_buffer * tie = nullptr)
+		: stream(&stream), tie(tie), mode(mode)
+	{
+	}
+	~out_buffer()
+	{
+		flush();
+	}
+	// hands everything to the streambuf and flushes that too
+	void flush()
+	{
+		write_out();
+		if (std::basic_streambuf<C> * buf = stream->rdbuf()) buf->pubsync();
+	}
+	void write_out()
+	{
+		if (!size) return;
+		if (tie) tie->flush();
+		if (std::basic_streambuf<C> * buf = stream->rdbuf()) buf->sputn(data.get(), std::streamsize(size));
+		size = 0;
+	}
+	// called when the buffer is full. the memory only gets allocated on the
+	// first write so that threads that never print don't pay for it
+	void make_room()
+	{
+		if (data) write_out();
+		else
+		{
+			data.reset(new C[buffer_size]);
+			capacity = buffer_size;
+		}
+	}
+	void write_large(const C * begin, const C * end)
+	{
+		write_out();
+		if (tie) tie->flush();
+		if (std::basic_streambuf<C> * buf = stream->rdbuf()) buf->sputn(begin, std::streamsize(end - begin));
+		end_of_write(begin, end);
+	}
+	void end_of_write(const C * begin, const C * end)
+	{
+		if (mode == out_mode::line && std::find(begin, end, C('\n')) != end) flush();
+	}
+
+	std::basic_ostream<C> * stream;
+	out_buffer * tie;
+	out_mode mode;
+	size_t size = 0;
+	size_t capacity = 0;
+	std::unique_ptr<C[]> data;
+};
+}
+template<typename C>
+struct out_it : std::iterator<std::output_iterator_tag, void, void, void, void>
+{
+	explicit out_it(detail::out_buffer<C> & buffer)
+		: buffer(&buffer)
+	{
+	}
+	out_it & operator=(C c)
+	{
+		if (buffer->size == buffer->capacity) buffer->make_room();
+		buffer->data[buffer->size++] = c;
+		if (c == C('\n') && buffer->mode == out_mode::line) buffer->flush();
+		return *this;
+	}
+	void write(const C * begin, const C * end)
+	{
+		size_t size = end - begin;
+		if (size == 0) return;
+		else if (size > buffer->capacity - buffer->size)
+		{
+			buffer->make_room();
+			if (size > buffer->capacity)
+			{
+				buffer->write_large(begin, end);
+				return;
+			}
+		}
+		std::memcpy(buffer->data.get() + buffer->size, begin, size * sizeof(C));
+		buffer->size += size;
+		buffer->end_of_write(begin, end);
+	}
+	// see detail::bounded_format
+	C * unchecked_begin(size_t size)
+	{
+		if (size > buffer->capacity - buffer->size)
+		{
+			buffer->make_room();
+			if (size > buffer->capacity) return nullptr;
+		}
+		return buffer->data.get() + buffer->size;
+	}
+	void unchecked_end(C * end)
+	{
+		C * begin = buffer->data.get() + buffer->size;
+		buffer->size = end - buffer->data.get();
+		buffer->end_of_write(begin, end);
+	}
+	out_it & operator*()
+	{
+		return *this;
+	}
+	out_it & operator++()
+	{
+		return *this;
+	}
+	out_it & operator++(int)
+	{
+		return *this;
+	}
+
+	void flush()
+	{
+		buffer->flush();
+	}
+	// only changes the mode for the current thread
+	void mode(out_mode mode)
+	{
+		buffer->mode = mode;
+	}
+	out_mode mode() const
+	{
+		return buffer->mode;
+	}
+
+private:
+	detail::out_buffer<C> * buffer;
+};
+
+extern thread_local format_it<char, out_it<char> > cout;
+extern thread_local format_it<char, out_it<char> > cerr;
+extern thread_local format_it<char, out_it<char> > clog;
+extern thread_local format_it<wchar_t, out_it<wchar_t> > wcout;
+extern thread_local format_it<wchar_t, out_it<wchar_t> > wcerr;
+extern thread_local format_it<wchar_t, out_it<wchar_t> > wclog;
+
+template<typename C>
+format_it<C, out_it<C> > & flush(format_it<C, out_it<C> > & it)
+{
+	it.it().flush();
+	return it;
+}
 }
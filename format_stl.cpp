@@ -34,6 +34,7 @@ For more information, please refer to <http://unlicense.org/>
 #include <array>
 #include <unordered_set>
 #include <unordered_map>
+#include <chrono>
 namespace
 {
 TEST(format_stl, tuple)
@@ -68,6 +69,19 @@ TEST(format_stl, vector)
 {
 	TestSortedContainer<std::vector<int> >();
 }
+TEST(format_stl, vector_of_numbers)
+{
+	std::vector<double> doubles = { 1.5, -2.0, 1e100 };
+	ASSERT_EQ("{ 1.5, -2, 1e+100 }", fmt::stack_print<1024>(doubles));
+	std::vector<bool> bools = { true, false };
+	ASSERT_EQ("{ 1, 0 }", fmt::stack_print<1024>(bools));
+	std::vector<char> chars = { 'a', 'b' };
+	ASSERT_EQ("{ a, b }", fmt::stack_print<1024>(chars));
+	std::vector<long long> many(100, -1234567890123ll);
+	std::string expected = "{ -1234567890123";
+	for (int i = 1; i < 100; ++i) expected += ", -1234567890123";
+	ASSERT_EQ(expected + " }", fmt::stack_print<4096>(many).c_str());
+}
 TEST(format_stl, deque)
 {
 	TestSortedContainer<std::deque<int> >();
@@ -137,5 +151,18 @@ TEST(format_stl, unordered_map)
 	fmt::stack_print<1024> b_empty(b);
 	ASSERT_EQ("{ }", b_empty);
 }
+TEST(format_stl, error_code)
+{
+	std::error_code error = std::make_error_code(std::errc::invalid_argument);
+	std::ostringstream expected;
+	expected << error;
+	ASSERT_EQ(expected.str(), fmt::stack_print<1024>(error).c_str());
+}
+TEST(format_stl, chrono)
+{
+	using namespace std::chrono;
+	ASSERT_EQ("5ns 6us 7ms 8s 9min 10h", fmt::stack_print<1024>(nanoseconds(5), microseconds(6), milliseconds(7), seconds(8), minutes(9), hours(10)));
+	ASSERT_EQ("1.5s -3[2]s 4[1/100]s", fmt::stack_print<1024>(duration<double>(1.5), duration<int, std::ratio<2> >(-3), duration<long, std::centi>(4)));
+}
 }
 #endif
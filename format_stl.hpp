@@ -25,6 +25,7 @@ For more information, please refer to <http://unlicense.org/>
 
 #include "stack_format.hpp"
 #include "format_helpers.hpp"
+#include <system_error>
 
 namespace std
 {
@@ -58,6 +59,11 @@ template<typename T, typename A>
 class list;
 template<typename T, typename A>
 class forward_list;
+namespace chrono
+{
+template<typename R, typename P>
+struct duration;
+}
 }
 
 namespace fmt
@@ -101,6 +107,35 @@ format_it<C, It> format(format_it<C, It> it, const std::tuple<Ts...> & value)
 {
 	return detail::TupleFormatter<sizeof...(Ts)>()(it, value);
 }
+// same as the ostream operator: category, colon, value
+template<typename C, typename It>
+format_it<C, It> format(format_it<C, It> it, const std::error_code & value)
+{
+	return it.printpacked(value.category().name(), ':', value.value());
+}
+namespace detail
+{
+// the unit suffixes of the C++20 duration operator<<, except that
+// microseconds are "us". nullptr for periods that don't have a name
+constexpr const char * duration_suffix(intmax_t num, intmax_t den)
+{
+	return num == 1 && den == 1000000000 ? "ns"
+		: num == 1 && den == 1000000 ? "us"
+		: num == 1 && den == 1000 ? "ms"
+		: num == 1 && den == 1 ? "s"
+		: num == 60 && den == 1 ? "min"
+		: num == 3600 && den == 1 ? "h"
+		: num == 86400 && den == 1 ? "d"
+		: nullptr;
+}
+}
+template<typename C, typename It, typename R, typename P>
+format_it<C, It> format(format_it<C, It> it, const std::chrono::duration<R, P> & value)
+{
+	if (const char * suffix = detail::duration_suffix(P::num, P::den)) return it.printpacked(value.count(), suffix);
+	else if (P::den == 1) return it.printpacked(value.count(), '[', intmax_t(P::num), "]s");
+	else return it.printpacked(value.count(), '[', intmax_t(P::num), '/', intmax_t(P::den), "]s");
+}
 namespace detail
 {
 template<typename C, typename It, typename T>
@@ -109,12 +144,24 @@ format_it<C, It> format_container(format_it<C, It> it, const T & value)
 	if (value.empty()) return it.print("{ }");
 	else return it.print('{', with_separator(value, ", "), '}');
 }
+// numbers in contiguous memory can use format_array
+template<typename C, typename It, typename T>
+format_it<C, It> format_contiguous_container(format_it<C, It> it, const T & value, std::false_type)
+{
+	return format_container(it, value);
+}
+template<typename C, typename It, typename T>
+format_it<C, It> format_contiguous_container(format_it<C, It> it, const T & value, std::true_type)
+{
+	if (value.empty()) return it.print("{ }");
+	else return it.print('{', format_array(value.data(), value.size(), ", "), '}');
+}
 }
 template<typename C, typename It, typename T>
 format_it<C, It> format(format_it<C, It> it, const std::initializer_list<T> & value)
 {
 	if (value.size() == 0) return it.print("{ }");
-	else return it.print('{', with_separator(value, ", "), '}');
+	else return it.print('{', format_array(value.begin(), value.size(), ", "), '}');
 }
 template<typename C, typename It, typename K, typename V, typename Comp, typename A>
 format_it<C, It> format(format_it<C, It> it, const std::map<K, V, Comp, A> & value)
@@ -159,7 +206,7 @@ format_it<C, It> format(format_it<C, It> it, const std::unordered_multiset<T, H,
 template<typename C, typename It, typename T, typename A>
 format_it<C, It> format(format_it<C, It> it, const std::vector<T, A> & value)
 {
-	return detail::format_container(it, value);
+	return detail::format_contiguous_container(it, value, detail::is_batch_formattable<T, C>());
 }
 template<typename C, typename It, typename T, typename A>
 format_it<C, It> format(format_it<C, It> it, const std::deque<T, A> & value)
@@ -179,6 +226,6 @@ format_it<C, It> format(format_it<C, It> it, const std::forward_list<T, A> & val
 template<typename C, typename It, typename T, size_t N>
 format_it<C, It> format(format_it<C, It> it, const std::array<T, N> & value)
 {
-	return it.print('{', with_separator(value, ", "), '}');
+	return it.print('{', format_array(value.data(), value.size(), ", "), '}');
 }
 }
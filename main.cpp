@@ -6,6 +6,7 @@
 #include "format_helpers.hpp"
 #include "format_stl.hpp"
 #include "format_out.hpp"
+#include "format_compile.hpp"
 #include <string>
 #include <iterator>
 
@@ -50,6 +51,8 @@ int main(int argc, char * argv[])
 {
 	// format "100, 0.5" into 1024 bytes of stack memory
 	fmt::stack_format<1024> format("%0, %1", 100, 0.5f);
+	// same as above, but the format string is parsed at compile time
+	fmt::stack_format<1024> compiled(FMT_COMPILE("%0, %1"), 100, 0.5f);
 
 	// print "Hello World" into 1024 bytes of stack memory
 	fmt::stack_print<1024> print("Hello", "World");
@@ -58,6 +61,8 @@ int main(int argc, char * argv[])
 	auto format_to_cout = fmt::make_format_it(std::ostreambuf_iterator<char>(std::cout));
 	*format_to_cout++ = format;
 	*format_to_cout++ = '\n';
+	*format_to_cout++ = compiled;
+	*format_to_cout++ = '\n';
 	*format_to_cout++ = print;
 	*format_to_cout++ = '\n';
 
@@ -73,6 +78,9 @@ int main(int argc, char * argv[])
 	// 3: { 1, 10, 100 }
 	//
 	fmt::cout.print(a_string);
+	// fmt::cout has its own buffer, so flush it before writing to std::cout
+	// another way
+	fmt::flush(fmt::cout);
 
 	// prints "1, a, 64"
 	std::transform(numbers.begin(), numbers.end(), fmt::with_separator(format_to_cout, ", "), &fmt::hex<int>);
@@ -99,6 +107,7 @@ int main(int argc, char * argv[])
 
 
 	fmt::cout.print(print_both(print_through_ostream(), print_through_format_it())).print('\n');
+	fmt::flush(fmt::cout);
 
 #ifndef DISABLE_GTEST
 	::testing::InitGoogleTest(&argc, argv);
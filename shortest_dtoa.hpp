@@ -0,0 +1,66 @@
+/*
+This is free and unencumbered software released into the public domain.
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+For more information, please refer to <http://unlicense.org/>
+*/
+
+#pragma once
+
+#include "double_conversion/fast-dtoa.h"
+#include <cstdint>
+
+namespace fmt
+{
+namespace detail
+{
+// the shortest decimal that reads back as the same floating point number is
+// mantissa * 10^exponent. if there are several, this is the one closest to
+// the number
+struct ShortestDecimal
+{
+	uint64_t mantissa;
+	int exponent;
+};
+
+// uses the Ryu algorithm by Ulf Adams. unlike Grisu in FastDtoa this always
+// succeeds on the first try, so there is no slow bignum fallback. the value
+// has to be finite and greater than zero
+ShortestDecimal ryu_shortest(double value);
+ShortestDecimal ryu_shortest(float value);
+
+// writes the digits of ryu_shortest into buffer in the same layout that
+// double_conversion uses. there are no trailing zeros and no null terminator
+static constexpr int ryu_max_length = 17;
+double_conversion::FastDtoaResult ryu_dtoa(double value, char * buffer);
+double_conversion::FastDtoaResult ryu_dtoa(float value, char * buffer);
+
+// the digits of value rounded to num_digits significant digits, without
+// trailing zeros. rounding the shortest representation gives the same digits
+// as rounding the exact value, except when it ends exactly on the halfway
+// point or when num_digits is so large that the shortest representation isn't
+// close enough, which is always the case for denormals. returns false in those
+// cases. floats are only accurate enough for fewer digits, but those are
+// computed with 32 bit math
+static constexpr int max_ryu_precision = 15;
+static constexpr int max_ryu_float_precision = 6;
+bool ryu_precision_dtoa(double value, int num_digits, char * buffer, double_conversion::FastDtoaResult & result);
+bool ryu_precision_dtoa(float value, int num_digits, char * buffer, double_conversion::FastDtoaResult & result);
+}
+}
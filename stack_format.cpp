@@ -22,9 +22,12 @@ For more information, please refer to <http://unlicense.org/>
 */
 
 #include "stack_format.hpp"
+#include "format_compile.hpp"
 
 #ifndef DISABLE_GTEST
 #include <gtest/gtest.h>
+#include <sstream>
+#include <random>
 namespace
 {
 TEST(stack_format, simple)
@@ -77,12 +80,40 @@ TEST(stack_format, multidigit_index)
 	fmt::stack_format<1024> foo("%0%1%2%3%4%5%6%7%8%9%10%11%12%13%00%02", 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13);
 	ASSERT_EQ("01234567891011121302", foo);
 }
+TEST(stack_format, multidigit_index_mixed_types)
+{
+	fmt::stack_format<1024> foo("%13 %12 %11 %10 %9 %8 %7 %6 %5 %4 %3 %2 %1 %0", 'a', "b", std::string("c"), 3u, 4.5, -5ll, 6.5f, true, static_cast<short>(8), fmt::hex(9), nullptr, 11ul, 'c', "end");
+	ASSERT_EQ("end c 11 nullptr 9 8 1 6.5 -5 4.5 3 c b a", foo);
+}
 TEST(stack_format, overflow)
 {
 	// this has to fall back to heap allocation
 	fmt::stack_format<4> foo("%0, %1", 10000.0f, 66.0f);
 	ASSERT_EQ("10000, 66", foo);
 }
+TEST(stack_format, overflow_size)
+{
+	fmt::stack_format<4> foo("%0, %1", 10000.0f, 66.0f);
+	ASSERT_EQ(9u, foo.size());
+	ASSERT_EQ(9, foo.end() - foo.begin());
+	std::stringstream stream;
+	stream << foo;
+	ASSERT_EQ("10000, 66", stream.str());
+	fmt::stack_print<0> zero_sized(1, 2, 3);
+	ASSERT_EQ(5u, zero_sized.size());
+}
+TEST(stack_format, overflow_in_bounded_argument)
+{
+	// the first argument fits completely, the others don't have enough space
+	// to use the unchecked path and overflow character by character
+	fmt::stack_format<16> foo("%0 %1 %2", 123, -2147483647 - 1, 4294967295u);
+	ASSERT_EQ("123 -2147483648 4294967295", foo);
+}
+TEST(stack_format, overflow_in_string)
+{
+	fmt::stack_format<8> foo("%0%1", "abc", std::string("defghijklmnop"));
+	ASSERT_EQ("abcdefghijklmnop", foo);
+}
 template<typename C = char>
 struct scoped_change_callback
 {
@@ -136,34 +167,126 @@ TEST(stack_format, overflow_callback_zero_sized)
 	fmt::stack_format<0>("%0%1", "foo", "bar");
 	ASSERT_FALSE(did_trigger);
 }
-static constexpr int profile_count = 2000000;
-TEST(stack_format, DISABLED_profile)
+TEST(stack_format, auto_size)
+{
+	auto foo = fmt::stack_format_auto("[%0, %1, %2]", -2147483647 - 1, 18446744073709551615llu, fmt::hex(-1));
+	ASSERT_EQ("[-2147483648, 18446744073709551615, -1]", foo);
+	auto print = fmt::stack_print_auto(true, 'a', -9223372036854775807ll - 1, -1.2345678e-300, "end");
+	ASSERT_EQ("1 a -9223372036854775808 -1.23457e-300 end", print);
+	static_assert(std::is_same<decltype(print), fmt::fixed_stack_format<1 + 1 + 20 + 13 + 3 + 5> >::value, "the sizes of the arguments, the separators and the null terminator");
+}
+TEST(stack_format, auto_size_compiled)
+{
+	auto foo = fmt::stack_format_auto(FMT_COMPILE("[%0, %1, %0]"), -32768, fmt::upperhex(0xffffffffu));
+	ASSERT_EQ("[-32768, FFFFFFFF, -32768]", foo);
+	static_assert(std::is_same<decltype(foo), fmt::fixed_stack_format<6 + 11 + 8 + 11 + 1> >::value, "exactly the size of the largest output");
+}
+// formats the value once through a sink without unchecked_begin and once
+// through stack_format, which takes the unchecked path for every type with a
+// max_formatted_size
+template<typename T>
+::testing::AssertionResult UncheckedMatchesChecked(const T & value)
+{
+	std::string checked;
+	fmt::make_format_it(std::back_inserter(checked)).format("%0", value);
+	fmt::stack_format<512> unchecked("%0", value);
+	std::string unchecked_string(unchecked.begin(), unchecked.end());
+	if (checked != unchecked_string) return ::testing::AssertionFailure() << "checked: \"" << checked << "\", unchecked: \"" << unchecked_string << '"';
+	else if (checked.size() > fmt::max_formatted_size<T>::value) return ::testing::AssertionFailure() << '"' << checked << "\" is longer than " << fmt::max_formatted_size<T>::value;
+	else return ::testing::AssertionSuccess();
+}
+template<typename T>
+::testing::AssertionResult IntegerUncheckedMatchesChecked(T value)
 {
-	for (int i = 0; i < profile_count; ++i)
+	::testing::AssertionResult results[] =
 	{
-		//fmt::stack_format<1024>("[%0, %1, %2]", i, i * 2, i / 2);
-		fmt::stack_format<1024>("[%0, %1, %2]", static_cast<float>(i), i * 2.0f, i / 2.0f);
-		//fmt::stack_format<1024>("[%0, %1, %2]", "foo", "bar", "baz");
+		UncheckedMatchesChecked(value),
+		UncheckedMatchesChecked(fmt::hex(value)),
+		UncheckedMatchesChecked(fmt::upperhex(value)),
+		UncheckedMatchesChecked(fmt::hex_fixed(value)),
+		UncheckedMatchesChecked(fmt::upperhex_fixed(value)),
+		UncheckedMatchesChecked(fmt::oct(value)),
+	};
+	for (const ::testing::AssertionResult & result : results)
+	{
+		if (!result) return result;
+	}
+	return ::testing::AssertionSuccess();
+}
+template<typename T>
+void TestIntegerUncheckedMatchesChecked()
+{
+	typedef std::numeric_limits<T> limits;
+	for (T value : { limits::min(), T(limits::min() + 1), T(-1), T(0), T(1), T(9), T(10), T(limits::max() / 10), T(limits::max() - 1), limits::max() })
+	{
+		ASSERT_TRUE(IntegerUncheckedMatchesChecked(value));
 	}
 }
-TEST(stack_format, DISABLED_profile_printf)
+template<typename T, size_t... NumDigits>
+::testing::AssertionResult FloatUncheckedMatchesChecked(T value, std::index_sequence<NumDigits...>)
 {
-	for (int i = 0; i < profile_count; ++i)
+	::testing::AssertionResult results[] =
+	{
+		UncheckedMatchesChecked(value),
+		UncheckedMatchesChecked(fmt::nodrift_float(value)),
+		UncheckedMatchesChecked(fmt::float_as_fixed(value)),
+		UncheckedMatchesChecked(fmt::pad_float<int(NumDigits) + 1>(value))...
+	};
+	for (const ::testing::AssertionResult & result : results)
 	{
-		char buffer[1024];
-		//snprintf(buffer, 1024, "[%d, %d, %d]", i, i * 2, i / 2);
-		snprintf(buffer, 1024, "[%g, %g, %g]", static_cast<float>(i), i * 2.0f, i / 2.0f);
-		//snprintf(buffer, 1024, "[%s, %s, %s]", "foo", "bar", "baz");
+		if (!result) return result;
 	}
+	return ::testing::AssertionSuccess();
 }
-TEST(stack_format, DISABLED_profile_stringstream)
+template<typename T, typename Bits>
+void TestFloatUncheckedMatchesChecked()
 {
-	for (int i = 0; i < profile_count; ++i)
+	typedef std::numeric_limits<T> limits;
+	std::vector<T> values = { T(0), -T(0), T(0.1), T(-1.5), T(123456.789), T(1e21), T(1e-7), T(9.9996942179524442e+37), limits::denorm_min(), limits::min(), -limits::max(), limits::max(), limits::infinity(), -limits::infinity(), limits::quiet_NaN() };
+	std::mt19937_64 random(5);
+	for (int i = 0; i < 1000; ++i)
+	{
+		Bits bits = Bits(random());
+		T value;
+		std::memcpy(&value, &bits, sizeof(value));
+		values.push_back(value);
+	}
+	for (T value : values)
+	{
+		ASSERT_TRUE(FloatUncheckedMatchesChecked(value, std::make_index_sequence<20>()));
+	}
+}
+TEST(stack_format, unchecked_matches_checked)
+{
+	TestIntegerUncheckedMatchesChecked<signed char>();
+	TestIntegerUncheckedMatchesChecked<unsigned char>();
+	TestIntegerUncheckedMatchesChecked<short>();
+	TestIntegerUncheckedMatchesChecked<unsigned short>();
+	TestIntegerUncheckedMatchesChecked<int>();
+	TestIntegerUncheckedMatchesChecked<unsigned int>();
+	TestIntegerUncheckedMatchesChecked<long>();
+	TestIntegerUncheckedMatchesChecked<unsigned long>();
+	TestIntegerUncheckedMatchesChecked<long long>();
+	TestIntegerUncheckedMatchesChecked<unsigned long long>();
+#ifdef FORMAT_INT128
+	TestIntegerUncheckedMatchesChecked<__int128>();
+	TestIntegerUncheckedMatchesChecked<unsigned __int128>();
+#endif
+	TestFloatUncheckedMatchesChecked<float, uint32_t>();
+	TestFloatUncheckedMatchesChecked<double, uint64_t>();
+	for (bool value : { false, true })
+	{
+		ASSERT_TRUE(UncheckedMatchesChecked(value));
+		ASSERT_TRUE(UncheckedMatchesChecked(fmt::boolalpha(value)));
+	}
+	int i = 0;
+	for (const void * value : { static_cast<const void *>(nullptr), static_cast<const void *>(&i), reinterpret_cast<const void *>(~uintptr_t(0)) })
 	{
-		//std::stringstream() << '[' << i << ", " << i * 2 << ", " << i / 2 << ']';
-		std::stringstream() << '[' << static_cast<float>(i) << ", " << i * 2.0f << ", " << i / 2.0f << ']';
-		//std::stringstream() << '[' << "foo" << ", " << "bar" << ", " << "baz" << ']';
+		ASSERT_TRUE(UncheckedMatchesChecked(value));
+		ASSERT_TRUE(UncheckedMatchesChecked(const_cast<void *>(value)));
 	}
+	ASSERT_TRUE(UncheckedMatchesChecked(nullptr));
+	ASSERT_TRUE(UncheckedMatchesChecked("a string literal"));
 }
 }
 #endif
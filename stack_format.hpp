@@ -36,74 +36,58 @@ template<typename C>
 void (*format_overflow_callback<C>::callback)(const C * begin, const C * end) = nullptr;
 namespace detail
 {
+// a single contiguous buffer that grows geometrically. after finish() it
+// is null terminated
 template<typename C, typename A>
 struct heap_format
 {
 	typedef std::vector<C, A> string_type;
-	typedef std::deque<C, A> string_builder_type;
 
-	heap_format()
-	{
-		new (&string_builder) string_builder_type();
-	}
-	~heap_format()
-	{
-		if (finished) finished_string.~string_type();
-		else string_builder.~string_builder_type();
-	}
 	void push_back(C c)
 	{
-		string_builder.push_back(c);
+		string.push_back(c);
 	}
 	template<typename It>
 	void insert(It begin, It end)
 	{
-		string_builder.insert(string_builder.end(), begin, end);
+		string.insert(string.end(), begin, end);
 	}
-	void reserve(size_t)
+	void reserve(size_t size)
 	{
+		string.reserve(size);
 	}
 	void finish()
 	{
-		string_builder.push_back(C('\0'));
-		string_type string(std::make_move_iterator(string_builder.begin()), std::make_move_iterator(string_builder.end()));
-		string_builder.~string_builder_type();
-		static_assert(noexcept(string_type(std::move(string))), "don't want to unwind while this class is in an invalid state");
-		new (&finished_string) string_type(std::move(string));
-		finished = true;
+		string.push_back(C('\0'));
 	}
 	const C * c_str() const
 	{
-		return finished_string.data();
+		return string.data();
 	}
 	C * begin()
 	{
-		return const_cast<C *>(const_cast<const heap_format &>(*this).begin());
+		return string.data();
 	}
 	C * end()
 	{
-		return const_cast<C *>(const_cast<const heap_format &>(*this).end());
+		return string.data() + size();
 	}
 	const C * begin() const
 	{
-		return finished_string.data();
+		return string.data();
 	}
 	const C * end() const
 	{
-		return finished_string.data() + finished_string.size();
+		return string.data() + size();
 	}
+	// doesn't include the null terminator
 	size_t size() const
 	{
-		return finished_string.size();
+		return string.size() - 1;
 	}
 
 private:
-	bool finished = false;
-	union
-	{
-		string_type finished_string;
-		string_builder_type string_builder;
-	};
+	string_type string;
 };
 
 template<typename C, typename FA>
@@ -142,6 +126,10 @@ struct stack_format_fallback
 	{
 		fallback.push_back(c);
 	}
+	void write_overflow(const C * begin, const C * end) FORMAT_NO_INLINE
+	{
+		fallback.insert(begin, end);
+	}
 	void finish(C * buffer, size_t num_bytes_remaining)
 	{
 		if (did_overflow()) fallback.finish();
@@ -209,6 +197,10 @@ struct heap_format_it : std::iterator<std::output_iterator_tag, void, void, void
 		heap->push_back(c);
 		return *this;
 	}
+	void write(const C * begin, const C * end)
+	{
+		heap->insert(begin, end);
+	}
 	heap_format_it & operator*()
 	{
 		return *this;
@@ -255,6 +247,40 @@ struct stack_format_it : std::iterator<std::output_iterator_tag, void, void, voi
 		}
 		return *this;
 	}
+	inline void write(const C * begin, const C * end)
+	{
+		size_t size = end - begin;
+		if (size < buffer_size)
+		{
+			std::memcpy(buffer, begin, size * sizeof(C));
+			buffer += size;
+			buffer_size -= size;
+			return;
+		}
+		// fill up the buffer one by one so that we overflow at the same place
+		// as operator= would
+		for (; begin != end && buffer_size != 0; ++begin)
+		{
+			*this = *begin;
+		}
+		if (begin != end) fallback->write_overflow(begin, end);
+	}
+	// see detail::bounded_format
+	inline C * unchecked_begin(size_t size)
+	{
+		if (size < buffer_size) return buffer;
+		else return nullptr;
+	}
+	inline void unchecked_end(C * end)
+	{
+		// unchecked_begin made sure that buffer_size is at least one. if a
+		// wrong max_formatted_size wrote more than that, clamp so that
+		// buffer_size doesn't wrap around and the null terminator stays in
+		// the buffer. the characters that didn't fit get cut off
+		size_t used = std::min(size_t(end - buffer), buffer_size - 1);
+		buffer += used;
+		buffer_size -= used;
+	}
 	stack_format_it & operator*()
 	{
 		return *this;
@@ -311,7 +337,7 @@ struct base_stack_format
 	}
 	bool did_overflow() const
 	{
-		return fallback.did_overflow;
+		return fallback.did_overflow();
 	}
 	bool operator==(const char * str) const
 	{
@@ -357,6 +383,11 @@ struct base_stack_format<0, C, FA>
 	{
 		return heap.c_str();
 	}
+	// there is no stack buffer that could overflow
+	bool did_overflow() const
+	{
+		return false;
+	}
 	bool operator==(const char * str) const
 	{
 		return strcmp(str, c_str()) == 0;
@@ -376,6 +407,117 @@ bool operator==(const char * str, const base_stack_format<Size, C, FA> & printer
 }
 }
 
+namespace detail
+{
+template<typename... T>
+struct max_of;
+template<>
+struct max_of<> : std::integral_constant<size_t, 0>
+{
+};
+template<typename First, typename... Rest>
+struct max_of<First, Rest...> : std::integral_constant<size_t, (max_formatted_size<First>::value > max_of<Rest...>::value ? max_formatted_size<First>::value : max_of<Rest...>::value)>
+{
+};
+// if the format string isn't known at compile time, we have to assume that
+// every "%0" in it is replaced by the biggest argument
+template<size_t FormatSize, typename... Args>
+struct max_runtime_format_size : std::integral_constant<size_t, (FormatSize - 1) + (FormatSize - 1) / 2 * max_of<Args...>::value>
+{
+};
+}
+
+// a buffer that is big enough for anything that gets formatted into it.
+// create these through stack_format_auto and stack_print_auto
+template<size_t Size, typename C = char>
+struct fixed_stack_format
+{
+	format_it<C, detail::unchecked_format_it<C> > build_iterator()
+	{
+		return { detail::unchecked_format_it<C>(buffer) };
+	}
+	void finish(format_it<C, detail::unchecked_format_it<C> > out)
+	{
+		*out.it().buffer = C('\0');
+		num_bytes_written = out.it().buffer - buffer;
+	}
+
+	C * begin()
+	{
+		return buffer;
+	}
+	C * end()
+	{
+		return buffer + num_bytes_written;
+	}
+	const C * begin() const
+	{
+		return buffer;
+	}
+	const C * end() const
+	{
+		return buffer + num_bytes_written;
+	}
+	size_t size() const
+	{
+		return num_bytes_written;
+	}
+	const C * c_str() const
+	{
+		return buffer;
+	}
+	bool operator==(const char * str) const
+	{
+		return strcmp(str, c_str()) == 0;
+	}
+
+private:
+	size_t num_bytes_written;
+	C buffer[Size];
+};
+template<size_t Size, typename C>
+bool operator==(const char * str, const fixed_stack_format<Size, C> & printer)
+{
+	return printer == str;
+}
+template<typename Traits, size_t Size, typename C>
+std::basic_ostream<C, Traits> & operator<<(std::basic_ostream<C, Traits> & lhs, const fixed_stack_format<Size, C> & printer)
+{
+	lhs.write(printer.c_str(), printer.size());
+	return lhs;
+}
+// like stack_format but the buffer size is computed from the types of the
+// arguments, so it never has to fall back to the heap. only works for types
+// that have a max_formatted_size. the size is much tighter when the format
+// string is wrapped in FMT_COMPILE
+template<typename C, size_t FormatSize, typename... Args>
+fixed_stack_format<detail::max_runtime_format_size<FormatSize, Args...>::value + 1, C> stack_format_auto(const C (&format_string)[FormatSize], const Args &... args)
+{
+	fixed_stack_format<detail::max_runtime_format_size<FormatSize, Args...>::value + 1, C> result;
+	auto out = result.build_iterator();
+	out.format(format_string, args...);
+	result.finish(out);
+	return result;
+}
+template<typename S, typename... Args>
+fixed_stack_format<compiled_format<S>::template max_size<Args...>() + 1, typename compiled_format<S>::char_type> stack_format_auto(compiled_format<S> format_string, const Args &... args)
+{
+	fixed_stack_format<compiled_format<S>::template max_size<Args...>() + 1, typename compiled_format<S>::char_type> result;
+	auto out = result.build_iterator();
+	out.format(format_string, args...);
+	result.finish(out);
+	return result;
+}
+template<typename C = char, typename... Args>
+fixed_stack_format<max_formatted_size<Args...>::value + sizeof...(Args), C> stack_print_auto(const Args &... args)
+{
+	fixed_stack_format<max_formatted_size<Args...>::value + sizeof...(Args), C> result;
+	auto out = result.build_iterator();
+	out.print(args...);
+	result.finish(out);
+	return result;
+}
+
 template<size_t Size, typename C = char, typename FA = std::allocator<C> >
 struct stack_format_func : detail::base_stack_format<Size, C, FA>
 {
@@ -0,0 +1,92 @@
+/*
+This is free and unencumbered software released into the public domain.
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+For more information, please refer to <http://unlicense.org/>
+*/
+
+#define FORMAT_STACK_SIZE_STATISTICS
+#include "stack_format_sites.hpp"
+
+namespace fmt
+{
+std::atomic<stack_format_site *> stack_format_site::head{nullptr};
+
+stack_format_site::stack_format_site(const char * file, int line, size_t buffer_size)
+	: file(file), line(line), buffer_size(buffer_size)
+{
+	stack_format_site * old_head = head.load(std::memory_order_relaxed);
+	do
+	{
+		next = old_head;
+	}
+	while (!head.compare_exchange_weak(old_head, this, std::memory_order_release, std::memory_order_relaxed));
+}
+
+size_t stack_format_site::recommended_size() const
+{
+	size_t needed = high_water_mark.load(std::memory_order_relaxed) + 1;
+	size_t result = 16;
+	while (result < needed) result *= 2;
+	return result;
+}
+}
+
+#ifndef DISABLE_GTEST
+#include <gtest/gtest.h>
+namespace
+{
+const fmt::stack_format_site * find_site(int line)
+{
+	const fmt::stack_format_site * result = nullptr;
+	fmt::for_each_stack_format_site([&](const fmt::stack_format_site & site)
+	{
+		if (site.line == line && std::strcmp(site.file, __FILE__) == 0) result = &site;
+	});
+	return result;
+}
+TEST(stack_format_sites, high_water_mark)
+{
+	int line = 0;
+	for (int i : { 1, 100, 10000 })
+	{
+		line = __LINE__; FMT_STACK_FORMAT(foo, 6, "[%0]", i);
+		ASSERT_EQ(fmt::stack_print<64>(i).size() + 2, foo.size());
+	}
+	const fmt::stack_format_site * site = find_site(line);
+	ASSERT_TRUE(site != nullptr);
+	ASSERT_EQ(6u, site->buffer_size);
+	ASSERT_EQ(3u, site->num_calls.load());
+	ASSERT_EQ(1u, site->num_overflows.load());
+	ASSERT_EQ(7u, site->high_water_mark.load());
+	ASSERT_EQ(16u, site->recommended_size());
+}
+TEST(stack_format_sites, report)
+{
+	int line = __LINE__; FMT_STACK_PRINT(foo, 1024, std::string(40, 'a'));
+	ASSERT_EQ(40u, foo.size());
+	const fmt::stack_format_site * site = find_site(line);
+	ASSERT_TRUE(site != nullptr);
+	ASSERT_EQ(64u, site->recommended_size());
+	fmt::stack_print<1024> report(*site);
+	fmt::stack_format<1024> expected("%0:%1: size 1024, used at most 40, overflowed 0 of 1 times, recommended size 64", __FILE__, line);
+	ASSERT_EQ(expected.c_str(), report);
+}
+}
+#endif
@@ -0,0 +1,108 @@
+/*
+This is free and unencumbered software released into the public domain.
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+For more information, please refer to <http://unlicense.org/>
+*/
+
+#pragma once
+
+#include "stack_format.hpp"
+#include <atomic>
+
+// use these instead of declaring a stack_format or stack_print directly to
+// find out how big the buffers at each call site should be:
+// FMT_STACK_FORMAT(foo, 1024, "%0, %1", 5, "bar");
+// is the same as
+// fmt::stack_format<1024> foo("%0, %1", 5, "bar");
+// but if FORMAT_STACK_SIZE_STATISTICS is defined, every call site also
+// keeps track of how many characters it needed and how often it overflowed.
+// fmt::for_each_stack_format_site gives you the results
+#ifdef FORMAT_STACK_SIZE_STATISTICS
+#define FMT_STACK_FORMAT(name, Size, ...)\
+	::fmt::stack_format<Size> name(__VA_ARGS__);\
+	static ::fmt::stack_format_site name##_stack_format_site(__FILE__, __LINE__, Size);\
+	name##_stack_format_site.record(name)
+#define FMT_STACK_PRINT(name, Size, ...)\
+	::fmt::stack_print<Size> name(__VA_ARGS__);\
+	static ::fmt::stack_format_site name##_stack_format_site(__FILE__, __LINE__, Size);\
+	name##_stack_format_site.record(name)
+#else
+#define FMT_STACK_FORMAT(name, Size, ...) ::fmt::stack_format<Size> name(__VA_ARGS__)
+#define FMT_STACK_PRINT(name, Size, ...) ::fmt::stack_print<Size> name(__VA_ARGS__)
+#endif
+
+namespace fmt
+{
+struct stack_format_site
+{
+	stack_format_site(const char * file, int line, size_t buffer_size);
+
+	template<size_t Size, typename C, typename FA>
+	void record(const detail::base_stack_format<Size, C, FA> & format)
+	{
+		record(format.size(), format.did_overflow());
+	}
+	void record(size_t size, bool overflowed)
+	{
+		num_calls.fetch_add(1, std::memory_order_relaxed);
+		if (overflowed) num_overflows.fetch_add(1, std::memory_order_relaxed);
+		size_t high_water = high_water_mark.load(std::memory_order_relaxed);
+		while (size > high_water && !high_water_mark.compare_exchange_weak(high_water, size, std::memory_order_relaxed))
+		{
+		}
+	}
+	// the smallest power of two that would have fit every call so far,
+	// including the null terminator
+	size_t recommended_size() const;
+
+	const char * file;
+	int line;
+	size_t buffer_size;
+	std::atomic<size_t> num_calls{0};
+	std::atomic<size_t> num_overflows{0};
+	std::atomic<size_t> high_water_mark{0};
+
+	// all sites are kept in a linked list
+	static const stack_format_site * first()
+	{
+		return head.load(std::memory_order_acquire);
+	}
+	const stack_format_site * next;
+
+private:
+	static std::atomic<stack_format_site *> head;
+};
+template<typename Func>
+void for_each_stack_format_site(Func && func)
+{
+	for (const stack_format_site * site = stack_format_site::first(); site; site = site->next)
+	{
+		func(*site);
+	}
+}
+template<typename C, typename It>
+format_it<C, It> format(format_it<C, It> it, const stack_format_site & site)
+{
+	return it.format("%0:%1: size %2, used at most %3, overflowed %4 of %5 times, recommended size %6",
+					site.file, site.line, site.buffer_size, site.high_water_mark.load(std::memory_order_relaxed),
+					site.num_overflows.load(std::memory_order_relaxed), site.num_calls.load(std::memory_order_relaxed),
+					site.recommended_size());
+}
+}
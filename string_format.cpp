@@ -0,0 +1,85 @@
+/*
+This is free and unencumbered software released into the public domain.
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+For more information, please refer to <http://unlicense.org/>
+*/
+
+#include "string_format.hpp"
+
+#ifndef DISABLE_GTEST
+#include <gtest/gtest.h>
+#include "format_compile.hpp"
+#include "format_helpers.hpp"
+#include <vector>
+namespace
+{
+TEST(string_format, format_to_string)
+{
+	ASSERT_EQ("[Hello, World, 5]", fmt::string_format("[%0, %1, %2]", "Hello", "World", 5));
+	ASSERT_EQ("[Hello, World, 5]", fmt::string_format(FMT_COMPILE("[%0, %1, %2]"), "Hello", "World", 5));
+	ASSERT_EQ("Hello World 5", fmt::string_print("Hello", "World", 5));
+}
+TEST(string_format, append)
+{
+	std::string test = "foo";
+	fmt::format_append(test, "%0%1", 10, std::string("bar"));
+	ASSERT_EQ("foo10bar", test);
+	fmt::print_append(test, 0.5, 'a');
+	ASSERT_EQ("foo10bar0.5 a", test);
+}
+TEST(string_format, vector)
+{
+	std::vector<char> test;
+	fmt::format_append(test, "%0, %1", 1234567890123ll, -1.5f);
+	ASSERT_EQ("1234567890123, -1.5", std::string(test.begin(), test.end()));
+}
+TEST(string_format, wchar)
+{
+	ASSERT_EQ(L"5: bar, 0.7", fmt::string_format<std::wstring>(L"%0: %1, %2", 5, L"bar", 0.7));
+}
+TEST(string_format, grow)
+{
+	// the estimate is too small because the argument is used several times,
+	// and the ostream fallback doesn't know anything about its size
+	std::string long_string(100, 'a');
+	std::string expected = long_string + long_string + long_string;
+	ASSERT_EQ(expected, fmt::string_format("%0%0%0", long_string));
+	std::vector<int> numbers(100, 12345);
+	std::string from_vector = fmt::string_print(fmt::with_separator(numbers, ","));
+	ASSERT_EQ(599u, from_vector.size());
+}
+TEST(string_format, exception)
+{
+	std::string test = "foo";
+	bool did_throw = false;
+	try
+	{
+		fmt::format_append(test, "%0%1", 10);
+	}
+	catch(const fmt::format_error & error)
+	{
+		did_throw = true;
+		ASSERT_EQ(fmt::format_error::FormatIndexOutOfRange, error.reason());
+	}
+	ASSERT_TRUE(did_throw);
+	ASSERT_EQ("foo", test);
+}
+}
+#endif
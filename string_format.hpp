@@ -0,0 +1,284 @@
+/*
+This is free and unencumbered software released into the public domain.
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+For more information, please refer to <http://unlicense.org/>
+*/
+
+#pragma once
+
+#include "format_it.hpp"
+#include <string>
+#include <cstring>
+
+namespace fmt
+{
+namespace detail
+{
+// an upper bound for how many characters a value will need. this is only
+// used to reserve memory up front so it's fine to be wrong. types that we
+// don't know anything about return 0 and the output grows as needed
+template<typename T>
+size_t size_estimate(const T &)
+{
+	return 0;
+}
+inline size_t size_estimate(bool)
+{
+	return 1;
+}
+inline size_t size_estimate(char)
+{
+	return 1;
+}
+inline size_t size_estimate(signed char)
+{
+	return 1;
+}
+inline size_t size_estimate(unsigned char)
+{
+	return 1;
+}
+inline size_t size_estimate(wchar_t)
+{
+	return 1;
+}
+inline size_t size_estimate(char16_t)
+{
+	return 1;
+}
+inline size_t size_estimate(char32_t)
+{
+	return 1;
+}
+inline size_t size_estimate(short)
+{
+	return 6;
+}
+inline size_t size_estimate(unsigned short)
+{
+	return 5;
+}
+inline size_t size_estimate(int)
+{
+	return 11;
+}
+inline size_t size_estimate(unsigned int)
+{
+	return 10;
+}
+inline size_t size_estimate(long)
+{
+	return 20;
+}
+inline size_t size_estimate(unsigned long)
+{
+	return 20;
+}
+inline size_t size_estimate(long long)
+{
+	return 20;
+}
+inline size_t size_estimate(unsigned long long)
+{
+	return 20;
+}
+// printf("%g") is never longer than 13 characters, but precise_float and
+// the other float formatters can print up to 17 digits plus sign, decimal
+// point and exponent
+inline size_t size_estimate(float)
+{
+	return 24;
+}
+inline size_t size_estimate(double)
+{
+	return 24;
+}
+template<typename C, typename T, typename A>
+size_t size_estimate(const std::basic_string<C, T, A> & string)
+{
+	return string.size();
+}
+template<typename C, size_t Size>
+size_t size_estimate(const C (&)[Size])
+{
+	return Size - 1;
+}
+inline size_t size_estimate(const char * string)
+{
+	return std::char_traits<char>::length(string);
+}
+template<typename S>
+size_t size_estimate(compiled_format<S>)
+{
+	return compiled_format<S>::size;
+}
+template<typename C>
+size_t size_estimate(const cached_format_string<C> & format_string)
+{
+	return format_string.end - format_string.begin;
+}
+inline size_t sum_size_estimates()
+{
+	return 0;
+}
+template<typename First, typename... Args>
+size_t sum_size_estimates(const First & first, const Args &... args)
+{
+	return size_estimate(first) + sum_size_estimates(args...);
+}
+
+// writes into the memory of a std::string or std::vector. the container
+// gets resized up front to the estimated size of the output and is then
+// written through a raw pointer. finish() shrinks it down to what was
+// actually written
+template<typename Container>
+struct contiguous_format_it : std::iterator<std::output_iterator_tag, void, void, void, void>
+{
+	typedef typename Container::value_type C;
+
+	contiguous_format_it(Container & container, size_t reserve)
+		: container(&container)
+	{
+		size_t used = container.size();
+		container.resize(used + std::max(reserve, size_t(16)));
+		reset_pointers(used);
+	}
+	inline contiguous_format_it & operator=(C c)
+	{
+		if (out == capacity_end) grow(1);
+		*out++ = c;
+		return *this;
+	}
+	inline void write(const C * begin, const C * end)
+	{
+		size_t size = end - begin;
+		if (size_t(capacity_end - out) < size) grow(size);
+		std::memcpy(out, begin, size * sizeof(C));
+		out += size;
+	}
+	// see detail::bounded_format
+	inline C * unchecked_begin(size_t size)
+	{
+		if (size_t(capacity_end - out) < size) grow(size);
+		return out;
+	}
+	inline void unchecked_end(C * end)
+	{
+		out = end;
+	}
+	contiguous_format_it & operator*()
+	{
+		return *this;
+	}
+	contiguous_format_it & operator++()
+	{
+		return *this;
+	}
+	contiguous_format_it & operator++(int)
+	{
+		return *this;
+	}
+
+	void finish()
+	{
+		container->resize(out - data);
+	}
+
+private:
+	Container * container;
+	C * data;
+	C * out;
+	C * capacity_end;
+
+	void reset_pointers(size_t used)
+	{
+		data = &(*container)[0];
+		out = data + used;
+		capacity_end = data + container->size();
+	}
+	void grow(size_t required) FORMAT_NO_INLINE
+	{
+		size_t used = out - data;
+		container->resize(std::max(container->size() * 2, used + required));
+		reset_pointers(used);
+	}
+};
+template<typename Container>
+struct contiguous_format
+{
+	typedef typename Container::value_type C;
+
+	contiguous_format(Container & container, size_t reserve)
+		: original_size(container.size()), it(detail::contiguous_format_it<Container>(container, reserve)), container(container)
+	{
+	}
+	~contiguous_format()
+	{
+		// only happens if formatting threw an exception
+		if (!finished) container.resize(original_size);
+	}
+	void finish()
+	{
+		it.it().finish();
+		finished = true;
+	}
+
+	size_t original_size;
+	format_it<C, contiguous_format_it<Container> > it;
+private:
+	Container & container;
+	bool finished = false;
+};
+}
+
+// appends the formatted arguments to the end of a std::basic_string or a
+// std::vector. see format_it::format for the syntax
+template<typename Container, typename... Args>
+Container & format_append(Container & out, const Args &... args)
+{
+	detail::contiguous_format<Container> format(out, detail::sum_size_estimates(args...));
+	format.it.format(args...);
+	format.finish();
+	return out;
+}
+// appends the arguments separated by spaces. see format_it::print
+template<typename Container, typename... Args>
+Container & print_append(Container & out, const Args &... args)
+{
+	detail::contiguous_format<Container> format(out, detail::sum_size_estimates(args...) + sizeof...(Args));
+	format.it.print(args...);
+	format.finish();
+	return out;
+}
+template<typename String = std::string, typename... Args>
+String string_format(const Args &... args)
+{
+	String result;
+	format_append(result, args...);
+	return result;
+}
+template<typename String = std::string, typename... Args>
+String string_print(const Args &... args)
+{
+	String result;
+	print_append(result, args...);
+	return result;
+}
+}
@@ -0,0 +1,92 @@
+/*
+This is free and unencumbered software released into the public domain.
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+For more information, please refer to <http://unlicense.org/>
+*/
+
+// turns a file written by fmt::binary_log back into text:
+// decode_binary_log trace.bin > trace.txt
+// build it with -DDISABLE_GTEST together with all the .cpp files of the
+// library
+
+#include "../format_binary.hpp"
+#include "../format_fd.hpp"
+#include <cstdio>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+int main(int argc, char * argv[])
+{
+	if (argc != 2)
+	{
+		std::fprintf(stderr, "usage: %s <binary log>\n", argv[0]);
+		return 2;
+	}
+	int fd = open(argv[1], O_RDONLY);
+	struct stat info;
+	if (fd < 0 || fstat(fd, &info) != 0)
+	{
+		std::perror(argv[1]);
+		return 1;
+	}
+	size_t size = size_t(info.st_size);
+	void * mapped = size ? mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0) : nullptr;
+	if (mapped == MAP_FAILED)
+	{
+		std::perror(argv[1]);
+		return 1;
+	}
+	madvise(mapped, size, MADV_SEQUENTIAL);
+	const char * begin = static_cast<const char *>(mapped);
+	fmt::binary_log_reader reader(begin, begin + size);
+	fmt::fd_writer out(STDOUT_FILENO);
+	auto it = fmt::make_format_it(out.sink());
+	int result = 0;
+	for (;;)
+	{
+		fmt::binary_log_reader::status status;
+		try
+		{
+			status = reader.render_next(it);
+		}
+		catch (const fmt::format_error & error)
+		{
+			it.format("<%0>\n", error.what());
+			continue;
+		}
+		if (status == fmt::binary_log_reader::ok) continue;
+		out.flush();
+		if (status == fmt::binary_log_reader::bad_header)
+		{
+			std::fprintf(stderr, "%s: not a binary log\n", argv[1]);
+			result = 1;
+		}
+		else if (status == fmt::binary_log_reader::truncated)
+		{
+			std::fprintf(stderr, "%s: the last %zu bytes are not a complete record\n", argv[1], size_t(begin + size - reader.remaining()));
+			result = 1;
+		}
+		break;
+	}
+	if (out.error()) result = 1;
+	return result;
+}
@@ -0,0 +1,530 @@
+/*
+This is free and unencumbered software released into the public domain.
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+For more information, please refer to <http://unlicense.org/>
+*/
+
+// measures the formatting functions and the sinks next to snprintf,
+// std::stringstream and std::to_chars doing the same work:
+// format_benchmark [--filter <text>] [--repeats <n>] [--min-time <ms>] [--json]
+// build it with optimizations and -DDISABLE_GTEST together with all the .cpp
+// files of the library. the std::to_chars comparisons need C++17
+//
+// every benchmark is warmed up until one run takes at least --min-time, then
+// that run is repeated and the median, minimum and standard deviation of the
+// repeats are reported. --json prints the same numbers in a form that can be
+// diffed between versions
+
+#include "../stack_format.hpp"
+#include "../string_format.hpp"
+#include "../format_stl.hpp"
+#include "../format_out.hpp"
+#include "../format_fd.hpp"
+#include "../format_mmap.hpp"
+#include "../format_log.hpp"
+#include "../format_binary.hpp"
+#include "../format_cache.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <random>
+#include <sstream>
+#include <unistd.h>
+#include <vector>
+#if __cplusplus >= 201703L && defined(__has_include)
+#if __has_include(<charconv>)
+#include <charconv>
+#endif
+#endif
+#if defined(__cpp_lib_to_chars)
+#define FORMAT_BENCHMARK_TO_CHARS
+#endif
+
+namespace
+{
+// each benchmark cycles through this many inputs so that the branch
+// predictor can't learn the digits
+constexpr size_t num_inputs = 1024;
+
+struct inputs
+{
+	inputs()
+	{
+		std::mt19937_64 random(12345);
+		for (size_t i = 0; i < num_inputs; ++i)
+		{
+			// uniform bits would almost always have the maximum number of
+			// digits, so pick the number of bits first
+			ints.push_back(static_cast<int>(random() >> (33 + random() % 31)) * (random() % 2 ? 1 : -1));
+			uint64s.push_back(random() >> random() % 64);
+			doubles.push_back(std::uniform_real_distribution<double>(1.0, 10.0)(random) * std::pow(10.0, static_cast<int>(random() % 17) - 8));
+			strings.push_back(words[random() % (sizeof(words) / sizeof(*words))]);
+		}
+		for (int i = 0; i < 16; ++i) container.push_back(ints[i]);
+		// for the shortest digit engines: any positive finite bit pattern, and
+		// the ones where Grisu gives up and double_conversion needs bignums
+		char buffer[double_conversion::kFastDtoaMaximalLength + 1];
+		while (random_bits_doubles.size() != num_inputs || grisu_failures.size() != num_inputs)
+		{
+			uint64_t bits = random() & 0x7fffffffffffffffllu;
+			double value;
+			std::memcpy(&value, &bits, sizeof(value));
+			if (!std::isfinite(value) || value == 0.0) continue;
+			if (random_bits_doubles.size() != num_inputs) random_bits_doubles.push_back(value);
+			if (grisu_failures.size() != num_inputs && !double_conversion::FastDtoa(value, double_conversion::FAST_DTOA_SHORTEST, 0, double_conversion::Vector<char>(buffer, sizeof(buffer))).succeeded)
+			{
+				grisu_failures.push_back(value);
+			}
+		}
+	}
+	static constexpr const char * words[] = { "a", "log", "user", "request", "a longer string with spaces", "status", "" };
+
+	std::vector<int> ints;
+	std::vector<uint64_t> uint64s;
+	std::vector<double> doubles;
+	std::vector<std::string> strings;
+	std::vector<int> container;
+	std::vector<double> random_bits_doubles;
+	std::vector<double> grisu_failures;
+};
+constexpr const char * inputs::words[];
+const inputs & input()
+{
+	static inputs result;
+	return result;
+}
+
+// the record that the sink benchmarks write
+const char record_format[] = "request %0 from %1 took %2ms\n";
+template<typename It>
+fmt::format_it<char, It> format_record(fmt::format_it<char, It> it, size_t i)
+{
+	return it.format(record_format, input().ints[i], input().strings[i], input().doubles[i]);
+}
+size_t record_size(size_t i)
+{
+	static std::vector<size_t> sizes = []
+	{
+		std::vector<size_t> result;
+		for (size_t i = 0; i < num_inputs; ++i) result.push_back(fmt::stack_format<256>(record_format, input().ints[i], input().strings[i], input().doubles[i]).size());
+		return result;
+	}();
+	return sizes[i];
+}
+size_t record_sizes(size_t count)
+{
+	size_t result = 0;
+	for (size_t i = 0; i < count; ++i) result += record_size(i % num_inputs);
+	return result;
+}
+
+int dev_null()
+{
+	static int fd = open("/dev/null", O_WRONLY | O_CLOEXEC);
+	return fd;
+}
+
+struct benchmark
+{
+	const char * group;
+	const char * name;
+	// runs the operation count times and returns the number of bytes written
+	std::function<size_t (size_t count)> run;
+};
+
+// benchmarks that format one value per iteration. the loops are written out
+// here so that each benchmark only has to say how to format the value
+template<typename F>
+benchmark each_int(const char * group, const char * name, F f)
+{
+	return { group, name, [f](size_t count)
+	{
+		size_t bytes = 0;
+		for (size_t i = 0; i < count; ++i) bytes += f(input().ints[i % num_inputs]);
+		return bytes;
+	}};
+}
+template<typename F>
+benchmark each_uint64(const char * group, const char * name, F f)
+{
+	return { group, name, [f](size_t count)
+	{
+		size_t bytes = 0;
+		for (size_t i = 0; i < count; ++i) bytes += f(input().uint64s[i % num_inputs]);
+		return bytes;
+	}};
+}
+template<typename F>
+benchmark each_double(const char * group, const char * name, F f)
+{
+	return { group, name, [f](size_t count)
+	{
+		size_t bytes = 0;
+		for (size_t i = 0; i < count; ++i) bytes += f(input().doubles[i % num_inputs]);
+		return bytes;
+	}};
+}
+// the engines behind nodrift_float, without the formatting around them.
+// the bytes are the number of digits
+template<typename F>
+benchmark each_shortest(const char * name, const std::vector<double> inputs::* values, F f)
+{
+	return { "shortest digits", name, [values, f](size_t count)
+	{
+		size_t bytes = 0;
+		char buffer[double_conversion::kFastDtoaMaximalLength + 1];
+		for (size_t i = 0; i < count; ++i) bytes += f((input().*values)[i % num_inputs], buffer).length;
+		return bytes;
+	}};
+}
+template<typename F>
+benchmark each_index(const char * group, const char * name, F f)
+{
+	return { group, name, [f](size_t count)
+	{
+		size_t bytes = 0;
+		for (size_t i = 0; i < count; ++i) bytes += f(i % num_inputs);
+		return bytes;
+	}};
+}
+
+template<typename T>
+size_t stream_size(const T & value)
+{
+	std::ostringstream stream;
+	stream << value;
+	return stream.str().size();
+}
+template<typename T>
+size_t stream_size_precision(const T & value, int precision)
+{
+	std::ostringstream stream;
+	stream << std::setprecision(precision) << value;
+	return stream.str().size();
+}
+#ifdef FORMAT_BENCHMARK_TO_CHARS
+template<typename... Args>
+size_t to_chars_size(Args... args)
+{
+	char buffer[512];
+	return std::to_chars(buffer, buffer + sizeof(buffer), args...).ptr - buffer;
+}
+#endif
+template<typename... Args>
+size_t snprintf_size(const char * format, Args... args)
+{
+	char buffer[512];
+	return snprintf(buffer, sizeof(buffer), format, args...);
+}
+
+std::vector<benchmark> all_benchmarks()
+{
+	std::vector<benchmark> result;
+	result.push_back(each_int("int", "fmt::stack_format", [](int value){ return fmt::stack_format<64>("%0", value).size(); }));
+	result.push_back(each_int("int", "fmt::format_append", [](int value)
+	{
+		static std::string out;
+		out.clear();
+		return fmt::format_append(out, "%0", value).size();
+	}));
+	result.push_back(each_int("int", "snprintf", [](int value){ return snprintf_size("%d", value); }));
+	result.push_back(each_int("int", "std::stringstream", [](int value){ return stream_size(value); }));
+#ifdef FORMAT_BENCHMARK_TO_CHARS
+	result.push_back(each_int("int", "std::to_chars", [](int value){ return to_chars_size(value); }));
+#endif
+	result.push_back(each_uint64("uint64 hex", "fmt::stack_format", [](uint64_t value){ return fmt::stack_format<64>("%0", fmt::hex(value)).size(); }));
+	result.push_back(each_uint64("uint64 hex", "snprintf", [](uint64_t value){ return snprintf_size("%llx", static_cast<unsigned long long>(value)); }));
+	result.push_back(each_uint64("uint64 hex", "std::stringstream", [](uint64_t value){ std::ostringstream stream; stream << std::hex << value; return stream.str().size(); }));
+#ifdef FORMAT_BENCHMARK_TO_CHARS
+	result.push_back(each_uint64("uint64 hex", "std::to_chars", [](uint64_t value){ return to_chars_size(value, 16); }));
+#endif
+
+	// the default format is the same as printf's %g
+	result.push_back(each_double("double %g", "fmt::stack_format", [](double value){ return fmt::stack_format<64>("%0", value).size(); }));
+	result.push_back(each_double("double %g", "snprintf", [](double value){ return snprintf_size("%g", value); }));
+	result.push_back(each_double("double %g", "std::stringstream", [](double value){ return stream_size(value); }));
+	// the shortest output that reads back as the same number. printf can
+	// only get there with %.17g, which prints too many digits
+	result.push_back(each_double("double shortest", "fmt::nodrift_float", [](double value){ return fmt::stack_format<64>("%0", fmt::nodrift_float(value)).size(); }));
+	result.push_back(each_double("double shortest", "snprintf %.17g", [](double value){ return snprintf_size("%.17g", value); }));
+	result.push_back(each_double("double shortest", "std::stringstream", [](double value){ return stream_size_precision(value, 17); }));
+#ifdef FORMAT_BENCHMARK_TO_CHARS
+	result.push_back(each_double("double shortest", "std::to_chars", [](double value){ return to_chars_size(value); }));
+#endif
+	auto ryu = [](double value, char (&buffer)[double_conversion::kFastDtoaMaximalLength + 1]){ return fmt::detail::ryu_dtoa(value, buffer); };
+	auto grisu = [](double value, char (&buffer)[double_conversion::kFastDtoaMaximalLength + 1]){ return fmt::detail::dtoa_into_buffer(buffer, value, double_conversion::FAST_DTOA_SHORTEST, double_conversion::BIGNUM_DTOA_SHORTEST, 0); };
+	result.push_back(each_shortest("ryu random bits", &inputs::random_bits_doubles, ryu));
+	result.push_back(each_shortest("double_conversion random bits", &inputs::random_bits_doubles, grisu));
+	result.push_back(each_shortest("ryu grisu failures", &inputs::grisu_failures, ryu));
+	result.push_back(each_shortest("double_conversion grisu failures", &inputs::grisu_failures, grisu));
+	result.push_back(each_double("double precision 10", "fmt::precise_float", [](double value){ return fmt::stack_format<64>("%0", fmt::precise_float(value, 10)).size(); }));
+	result.push_back(each_double("double precision 10", "snprintf", [](double value){ return snprintf_size("%.10g", value); }));
+	result.push_back(each_double("double precision 10", "std::stringstream", [](double value){ return stream_size_precision(value, 10); }));
+#ifdef FORMAT_BENCHMARK_TO_CHARS
+	result.push_back(each_double("double precision 10", "std::to_chars", [](double value){ return to_chars_size(value, std::chars_format::general, 10); }));
+#endif
+	result.push_back(each_double("double fixed", "fmt::float_as_fixed", [](double value){ return fmt::stack_format<512>("%0", fmt::float_as_fixed(value)).size(); }));
+#ifdef FORMAT_BENCHMARK_TO_CHARS
+	result.push_back(each_double("double fixed", "std::to_chars", [](double value){ return to_chars_size(value, std::chars_format::fixed); }));
+#endif
+	// printf has nothing that fills a fixed number of characters
+	result.push_back(each_double("double width 10", "fmt::pad_float", [](double value){ return fmt::stack_format<64>("%0", fmt::pad_float(value, 10)).size(); }));
+	result.push_back(each_double("double width 10", "fmt::pad_float<10>", [](double value){ return fmt::stack_format<64>("%0", fmt::pad_float<10>(value)).size(); }));
+
+	result.push_back(each_index("strings", "fmt::stack_format", [](size_t i)
+	{
+		return fmt::stack_format<256>("%0: %1, %2", input().strings[i], input().strings[(i + 1) % num_inputs], input().strings[(i + 2) % num_inputs]).size();
+	}));
+	result.push_back(each_index("strings", "snprintf", [](size_t i)
+	{
+		return snprintf_size("%s: %s, %s", input().strings[i].c_str(), input().strings[(i + 1) % num_inputs].c_str(), input().strings[(i + 2) % num_inputs].c_str());
+	}));
+	result.push_back(each_index("strings", "std::stringstream", [](size_t i)
+	{
+		std::ostringstream stream;
+		stream << input().strings[i] << ": " << input().strings[(i + 1) % num_inputs] << ", " << input().strings[(i + 2) % num_inputs];
+		return stream.str().size();
+	}));
+
+	// format strings that aren't literals, for example from a translation
+	// table
+	result.push_back(each_index("runtime format", "std::string", [](size_t i)
+	{
+		static const std::string format = "request %0 from %1 took %2ms, %3 bytes";
+		return fmt::stack_format<256>(format, input().ints[i], input().strings[i], input().ints[(i + 1) % num_inputs], input().uint64s[i]).size();
+	}));
+	result.push_back(each_index("runtime format", "fmt::cached", [](size_t i)
+	{
+		static const std::string format = "request %0 from %1 took %2ms, %3 bytes";
+		return fmt::stack_format<256>(fmt::cached(format), input().ints[i], input().strings[i], input().ints[(i + 1) % num_inputs], input().uint64s[i]).size();
+	}));
+
+	result.push_back(each_index("vector<int>", "fmt::stack_format", [](size_t)
+	{
+		return fmt::stack_format<512>("%0", input().container).size();
+	}));
+	result.push_back(each_index("vector<int>", "std::stringstream", [](size_t)
+	{
+		std::ostringstream stream;
+		stream << "{ ";
+		bool first = true;
+		for (int value : input().container)
+		{
+			if (!first) stream << ", ";
+			first = false;
+			stream << value;
+		}
+		stream << " }";
+		return stream.str().size();
+	}));
+
+	result.push_back(each_int("padding", "fmt::pad_left", [](int value){ return fmt::stack_format<64>("%0", fmt::pad_left(value, 12)).size(); }));
+	result.push_back(each_int("padding", "snprintf %12d", [](int value){ return snprintf_size("%12d", value); }));
+	result.push_back(each_int("padding", "std::stringstream setw", [](int value){ std::ostringstream stream; stream << std::setw(12) << value; return stream.str().size(); }));
+	result.push_back(each_int("padding", "fmt::pad_int", [](int value){ return fmt::stack_format<64>("%0", fmt::pad_int(value, 12)).size(); }));
+	result.push_back(each_int("padding", "snprintf %012d", [](int value){ return snprintf_size("%012d", value); }));
+
+	// the sinks all write the same records. each run creates its own sink, so
+	// opening and closing is part of the measurement but gets amortized
+	result.push_back(each_index("sinks", "fmt::stack_format", [](size_t i)
+	{
+		return fmt::stack_format<256>(record_format, input().ints[i], input().strings[i], input().doubles[i]).size();
+	}));
+	result.push_back({ "sinks", "fmt::format_append", [](size_t count)
+	{
+		std::string out;
+		size_t bytes = 0;
+		for (size_t i = 0; i < count; ++i)
+		{
+			out.clear();
+			bytes += fmt::format_append(out, record_format, input().ints[i % num_inputs], input().strings[i % num_inputs], input().doubles[i % num_inputs]).size();
+		}
+		return bytes;
+	}});
+	result.push_back({ "sinks", "std::back_inserter", [](size_t count)
+	{
+		std::string out;
+		auto it = fmt::make_format_it(std::back_inserter(out));
+		size_t bytes = 0;
+		for (size_t i = 0; i < count; ++i)
+		{
+			out.clear();
+			format_record(it, i % num_inputs);
+			bytes += out.size();
+		}
+		return bytes;
+	}});
+	result.push_back({ "sinks", "fmt::fd_writer", [](size_t count)
+	{
+		fmt::fd_writer writer(dev_null());
+		auto it = fmt::make_format_it(writer.sink());
+		for (size_t i = 0; i < count; ++i) format_record(it, i % num_inputs);
+		writer.flush();
+		return record_sizes(count);
+	}});
+	result.push_back({ "sinks", "fmt::mmap_file", [](size_t count)
+	{
+		char path[] = "/tmp/format_benchmark_XXXXXX";
+		int fd = mkstemp(path);
+		if (fd < 0) return size_t(0);
+		close(fd);
+		size_t bytes;
+		{
+			// small chunks so that the cost of populating the pages follows the
+			// number of bytes written
+			fmt::mmap_file file(path, 1 << 20);
+			auto it = fmt::make_format_it(file.sink());
+			for (size_t i = 0; i < count; ++i) format_record(it, i % num_inputs);
+			file.close();
+			bytes = file.size();
+		}
+		unlink(path);
+		return bytes;
+	}});
+	// bytes are counted as the text that the records stand for
+	result.push_back({ "sinks", "fmt::binary_log", [](size_t count)
+	{
+		fmt::fd_writer writer(dev_null());
+		fmt::binary_log<fmt::fd_sink> log(fmt::make_format_it(writer.sink()));
+		for (size_t i = 0; i < count; ++i) log.format(record_format, input().ints[i % num_inputs], input().strings[i % num_inputs], input().doubles[i % num_inputs]);
+		writer.flush();
+		return record_sizes(count);
+	}});
+	result.push_back({ "sinks", "fmt::async_logger", [](size_t count)
+	{
+		fmt::async_logger log(dev_null());
+		for (size_t i = 0; i < count; ++i) log.format(record_format, input().ints[i % num_inputs], input().strings[i % num_inputs], input().doubles[i % num_inputs]);
+		log.flush();
+		return record_sizes(count);
+	}});
+	result.push_back({ "sinks", "fprintf", [](size_t count)
+	{
+		FILE * file = fdopen(dup(dev_null()), "w");
+		for (size_t i = 0; i < count; ++i) fprintf(file, "request %d from %s took %gms\n", input().ints[i % num_inputs], input().strings[i % num_inputs].c_str(), input().doubles[i % num_inputs]);
+		fclose(file);
+		return record_sizes(count);
+	}});
+	result.push_back({ "sinks", "std::ofstream", [](size_t count)
+	{
+		std::ofstream file("/dev/null");
+		for (size_t i = 0; i < count; ++i) file << "request " << input().ints[i % num_inputs] << " from " << input().strings[i % num_inputs] << " took " << input().doubles[i % num_inputs] << "ms\n";
+		file.flush();
+		return record_sizes(count);
+	}});
+	return result;
+}
+
+// written to so that the compiler can't throw away the formatting
+volatile size_t total_bytes = 0;
+
+struct measurement
+{
+	size_t iterations = 0;
+	double bytes_per_op = 0.0;
+	double median = 0.0;
+	double min = 0.0;
+	double stddev = 0.0;
+};
+
+double run_once(const benchmark & to_run, size_t count)
+{
+	auto start = std::chrono::steady_clock::now();
+	total_bytes += to_run.run(count);
+	return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+measurement measure(const benchmark & to_run, int repeats, double min_time_ns)
+{
+	measurement result;
+	// the warmup doubles the count until a run takes long enough. it starts
+	// at one pass over the inputs so that sinks are never measured on a
+	// single record
+	size_t count = num_inputs;
+	while (run_once(to_run, count) < min_time_ns && count < (size_t(1) << 40)) count *= 2;
+	result.iterations = count;
+	std::vector<double> ns_per_op;
+	for (int i = 0; i < repeats; ++i) ns_per_op.push_back(run_once(to_run, count) / count);
+	std::sort(ns_per_op.begin(), ns_per_op.end());
+	result.median = ns_per_op[ns_per_op.size() / 2];
+	if (ns_per_op.size() % 2 == 0) result.median = (result.median + ns_per_op[ns_per_op.size() / 2 - 1]) / 2.0;
+	result.min = ns_per_op.front();
+	double mean = 0.0;
+	for (double value : ns_per_op) mean += value;
+	mean /= ns_per_op.size();
+	double variance = 0.0;
+	for (double value : ns_per_op) variance += (value - mean) * (value - mean);
+	result.stddev = std::sqrt(variance / ns_per_op.size());
+	result.bytes_per_op = static_cast<double>(to_run.run(num_inputs)) / num_inputs;
+	return result;
+}
+}
+
+int main(int argc, char * argv[])
+{
+	const char * filter = "";
+	int repeats = 15;
+	double min_time_ms = 20.0;
+	bool json = false;
+	for (int i = 1; i < argc; ++i)
+	{
+		if (!strcmp(argv[i], "--json")) json = true;
+		else if (!strcmp(argv[i], "--filter") && i + 1 < argc) filter = argv[++i];
+		else if (!strcmp(argv[i], "--repeats") && i + 1 < argc) repeats = std::max(1, atoi(argv[++i]));
+		else if (!strcmp(argv[i], "--min-time") && i + 1 < argc) min_time_ms = atof(argv[++i]);
+		else
+		{
+			fmt::cerr.format("usage: %0 [--filter <text>] [--repeats <n>] [--min-time <ms>] [--json]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	auto & out = fmt::cout;
+	if (json) out.format("{\n\t\"repeats\": %0,\n\t\"benchmarks\": [", repeats);
+	else out.printpacked(fmt::pad_right("benchmark", 52), fmt::pad_left("ns/op", 10), fmt::pad_left("min", 10), fmt::pad_left("stddev", 10), fmt::pad_left("MB/s", 10), '\n');
+	bool first = true;
+	for (const benchmark & to_run : all_benchmarks())
+	{
+		std::string name = fmt::string_format("%0/%1", to_run.group, to_run.name);
+		if (name.find(filter) == std::string::npos) continue;
+		measurement result = measure(to_run, repeats, min_time_ms * 1e6);
+		double bytes_per_second = result.bytes_per_op / result.median * 1e9;
+		if (json)
+		{
+			out.format("%0\n\t\t{ \"group\": \"%1\", \"name\": \"%2\", \"iterations\": %3, \"ns_per_op\": %4, \"ns_per_op_min\": %5, \"ns_per_op_stddev\": %6, \"bytes_per_op\": %7, \"bytes_per_second\": %8 }",
+				first ? "" : ",", to_run.group, to_run.name, result.iterations, fmt::nodrift_float(result.median), fmt::nodrift_float(result.min), fmt::nodrift_float(result.stddev), fmt::nodrift_float(result.bytes_per_op), fmt::nodrift_float(bytes_per_second));
+		}
+		else
+		{
+			out.printpacked(fmt::pad_right(name, 52), fmt::pad_left(fmt::pad_float(result.median, 8), 10), fmt::pad_left(fmt::pad_float(result.min, 8), 10), fmt::pad_left(fmt::pad_float(result.stddev, 8), 10), fmt::pad_left(fmt::pad_float(bytes_per_second / 1e6, 8), 10), '\n');
+		}
+		fmt::flush(out);
+		first = false;
+	}
+	if (json) out.format("\n\t]\n}\n");
+	fmt::flush(out);
+	return 0;
+}
@@ -0,0 +1,410 @@
+/*
+This is free and unencumbered software released into the public domain.
+Anyone is free to copy, modify, publish, use, compile, sell, or
+distribute this software, either in source code form or as a compiled
+binary, for any purpose, commercial or non-commercial, and by any
+means.
+In jurisdictions that recognize copyright laws, the author or authors
+of this software dedicate any and all copyright interest in the
+software to the public domain. We make this dedication for the benefit
+of the public at large and to the detriment of our heirs and
+successors. We intend this dedication to be an overt act of
+relinquishment in perpetuity of all present and future rights to this
+software under copyright law.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+For more information, please refer to <http://unlicense.org/>
+*/
+
+// checks every float mode against a reference for all 2^32 single precision
+// values:
+// verify_floats [--threads <n>] [--shard <k>/<n>] [--begin <bits>] [--end <bits>]
+//               [--mode <name>]... [--report <path>] [--max-reported <n>]
+// the references are printf for "%g" and precise_float, the bignum slow path
+// for pad_float, and the shortest digits of double_conversion for
+// float_as_fixed and nodrift_float. nodrift_float also has to read back as
+// the same float. build it with optimizations and -DDISABLE_GTEST together
+// with all the .cpp files of the library
+//
+// --shard k/n checks the k-th of n equal parts of the range, so that several
+// machines can split the work. every mismatch is counted, the first
+// --max-reported of them are written to the report sorted by their bits.
+// exits with 1 if there were any mismatches
+
+#include "../stack_format.hpp"
+#include "../string_format.hpp"
+#include "../format_out.hpp"
+#include "../format_fd.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <memory>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace
+{
+enum float_mode
+{
+	mode_g,
+	mode_precise_float,
+	mode_pad_float,
+	mode_float_as_fixed,
+	mode_nodrift_float,
+	num_modes
+};
+const char * const mode_names[num_modes] = { "%g", "precise_float", "pad_float", "float_as_fixed", "nodrift_float" };
+const int precisions[] = { 1, 3, 6, 9 };
+const int pad_width = 10;
+
+struct mismatch
+{
+	uint32_t bits;
+	float_mode mode;
+	std::string expected;
+	std::string actual;
+};
+
+// the state of one thread. the range is packed into one word as
+// begin << 32 | end so that the owner and the thieves can both change it
+// with a single compare and swap
+struct worker
+{
+	std::atomic<uint64_t> range{0};
+	uint64_t mismatches[num_modes] = {};
+	std::vector<mismatch> reported;
+	// the value that the reference had and the value that was printed
+	std::string expected;
+	std::string actual;
+};
+uint64_t pack(uint32_t begin, uint32_t end)
+{
+	return uint64_t(begin) << 32 | end;
+}
+
+struct verifier
+{
+	uint64_t first_value = 0;
+	uint64_t end_value = uint64_t(1) << 32;
+	unsigned modes = (1u << num_modes) - 1;
+	size_t max_reported = 1000;
+	std::vector<std::unique_ptr<worker> > workers;
+	std::atomic<uint64_t> checked{0};
+	std::atomic<uint64_t> num_mismatches{0};
+	std::atomic<size_t> num_reported{0};
+
+	// the values are handed out in blocks. a block is small enough that the
+	// last blocks don't leave threads idle for long
+	static constexpr uint64_t block_size = 4096;
+
+	uint32_t num_blocks() const
+	{
+		return uint32_t((end_value - first_value + block_size - 1) / block_size);
+	}
+	void run(size_t num_threads)
+	{
+		uint32_t blocks = num_blocks();
+		for (size_t i = 0; i < num_threads; ++i)
+		{
+			workers.emplace_back(new worker);
+			workers.back()->range.store(pack(uint32_t(blocks * i / num_threads), uint32_t(blocks * (i + 1) / num_threads)));
+		}
+		std::vector<std::thread> threads;
+		for (size_t i = 0; i < num_threads; ++i)
+		{
+			threads.emplace_back([this, i]{ work(*workers[i]); });
+		}
+		for (std::thread & thread : threads) thread.join();
+	}
+
+private:
+	void work(worker & self)
+	{
+		for (;;)
+		{
+			uint32_t block;
+			while (take_front(self.range, block))
+			{
+				uint64_t begin = first_value + block * block_size;
+				uint64_t end = std::min(begin + block_size, end_value);
+				for (uint64_t bits = begin; bits < end; ++bits) check(self, uint32_t(bits));
+				checked += end - begin;
+			}
+			if (!steal(self)) return;
+		}
+	}
+	static bool take_front(std::atomic<uint64_t> & range, uint32_t & block)
+	{
+		uint64_t old = range.load();
+		for (;;)
+		{
+			uint32_t begin = uint32_t(old >> 32);
+			uint32_t end = uint32_t(old);
+			if (begin >= end) return false;
+			if (range.compare_exchange_weak(old, pack(begin + 1, end)))
+			{
+				block = begin;
+				return true;
+			}
+		}
+	}
+	// takes the back half of the largest range of another thread. only the
+	// owner puts work into its own range, and it only does that when the
+	// range is empty, so the total amount of work never changes
+	bool steal(worker & self)
+	{
+		for (;;)
+		{
+			worker * victim = nullptr;
+			uint64_t victim_range = 0;
+			uint32_t largest = 0;
+			for (const std::unique_ptr<worker> & other : workers)
+			{
+				uint64_t range = other->range.load();
+				uint32_t size = uint32_t(range) - std::min(uint32_t(range >> 32), uint32_t(range));
+				if (size > largest)
+				{
+					largest = size;
+					victim = other.get();
+					victim_range = range;
+				}
+			}
+			if (!victim) return false;
+			uint32_t begin = uint32_t(victim_range >> 32);
+			uint32_t end = uint32_t(victim_range);
+			uint32_t middle = begin + (end - begin) / 2;
+			if (victim->range.compare_exchange_strong(victim_range, pack(begin, middle)))
+			{
+				self.range.store(pack(middle, end));
+				return true;
+			}
+		}
+	}
+
+	void check(worker & self, uint32_t bits)
+	{
+		float value;
+		std::memcpy(&value, &bits, sizeof(value));
+		double as_double = value;
+		char buffer[64];
+		if (modes & (1u << mode_g))
+		{
+			snprintf(buffer, sizeof(buffer), "%g", as_double);
+			compare(self, bits, mode_g, buffer, value);
+		}
+		if (modes & (1u << mode_precise_float))
+		{
+			for (int precision : precisions)
+			{
+				snprintf(buffer, sizeof(buffer), "%.*g", precision, as_double);
+				compare(self, bits, mode_precise_float, buffer, fmt::precise_float(value, precision));
+			}
+		}
+		if (modes & (1u << mode_pad_float))
+		{
+			pad_reference(self.expected, value);
+			compare(self, bits, mode_pad_float, self.expected.c_str(), fmt::pad_float(value, pad_width));
+		}
+		if (modes & (1u << mode_float_as_fixed))
+		{
+			fixed_reference(self.expected, value);
+			compare(self, bits, mode_float_as_fixed, self.expected.c_str(), fmt::float_as_fixed(value));
+		}
+		if (modes & (1u << mode_nodrift_float))
+		{
+			double_conversion::StringBuilder builder(buffer, sizeof(buffer));
+			double_conversion::DoubleToStringConverter::EcmaScriptConverter().ToShortestSingle(value, builder);
+			if (compare(self, bits, mode_nodrift_float, builder.Finalize(), fmt::nodrift_float(value)) && !std::isnan(value))
+			{
+				// ecmascript prints -0 as "0", so this can't compare the bits
+				float read = std::strtof(buffer, nullptr);
+				if (read != value)
+				{
+					self.actual.clear();
+					fmt::print_append(self.actual, "reads back as", fmt::nodrift_float(read));
+					report(self, bits, mode_nodrift_float, buffer);
+				}
+			}
+		}
+	}
+	// writes the sign and returns true if the value has no digits. the
+	// digit generators can't handle zero, infinity or nan
+	static bool special_reference(std::string & out, float & value)
+	{
+		out.clear();
+		if (std::signbit(value)) out += '-';
+		value = std::fabs(value);
+		if (std::isnan(value)) out += "nan";
+		else if (value == 0.0f) out += '0';
+		else if (std::isinf(value)) out += "inf";
+		else return false;
+		return true;
+	}
+	// the sign counts towards the width. special values are padded to the
+	// width too
+	static void pad_reference(std::string & out, float value)
+	{
+		int width = std::signbit(value) ? pad_width - 1 : pad_width;
+		if (special_reference(out, value))
+		{
+			if (value == 0.0f) out.append(1, '.').append(width - 2, '0');
+			else out.append(width - 3, ' ');
+		}
+		else fmt::detail::fixed_width_dtoa_slow(fmt::make_format_it(std::back_inserter(out)), static_cast<double>(value), width);
+	}
+	// the shortest digits laid out without an exponent, the way
+	// float_as_fixed is specified
+	static void fixed_reference(std::string & out, float value)
+	{
+		if (!special_reference(out, value))
+		{
+			char digits[double_conversion::DoubleToStringConverter::kBase10MaximalLength + 1];
+			auto result = double_conversion::DoubleToStringConverter::DoubleToAscii(value, double_conversion::DoubleToStringConverter::SHORTEST_SINGLE, 0, digits, sizeof(digits));
+			if (result.decimal_point <= 0) out.append("0.").append(-result.decimal_point, '0').append(digits, result.length);
+			else if (result.decimal_point < result.length) out.append(digits, result.decimal_point).append(1, '.').append(digits + result.decimal_point, result.length - result.decimal_point);
+			else out.append(digits, result.length).append(result.decimal_point - result.length, '0');
+		}
+	}
+	template<typename T>
+	bool compare(worker & self, uint32_t bits, float_mode mode, const char * expected, const T & value)
+	{
+		fmt::stack_print<512> printed(value);
+		size_t size = std::strlen(expected);
+		if (printed.size() == size && std::equal(printed.begin(), printed.end(), expected)) return true;
+		self.actual.assign(printed.begin(), printed.end());
+		report(self, bits, mode, expected);
+		return false;
+	}
+	void report(worker & self, uint32_t bits, float_mode mode, const char * expected)
+	{
+		++self.mismatches[mode];
+		++num_mismatches;
+		if (num_reported.fetch_add(1) < max_reported) self.reported.push_back({ bits, mode, expected, self.actual });
+	}
+};
+constexpr uint64_t verifier::block_size;
+
+bool parse_mode(const char * name, unsigned & modes)
+{
+	for (int i = 0; i < num_modes; ++i)
+	{
+		if (std::strcmp(name, mode_names[i])) continue;
+		modes |= 1u << i;
+		return true;
+	}
+	return false;
+}
+}
+
+int main(int argc, char * argv[])
+{
+	verifier verify;
+	size_t num_threads = std::max(1u, std::thread::hardware_concurrency());
+	unsigned shard = 0;
+	unsigned num_shards = 1;
+	unsigned modes = 0;
+	const char * report_path = nullptr;
+	for (int i = 1; i < argc; ++i)
+	{
+		const char * argument = argv[i];
+		const char * value = i + 1 < argc ? argv[i + 1] : nullptr;
+		bool valid = value != nullptr;
+		if (!valid) {}
+		else if (!std::strcmp(argument, "--threads")) num_threads = std::max(1l, std::strtol(value, nullptr, 0));
+		else if (!std::strcmp(argument, "--shard")) valid = std::sscanf(value, "%u/%u", &shard, &num_shards) == 2 && shard < num_shards;
+		else if (!std::strcmp(argument, "--begin")) verify.first_value = std::strtoull(value, nullptr, 0);
+		else if (!std::strcmp(argument, "--end")) verify.end_value = std::strtoull(value, nullptr, 0);
+		else if (!std::strcmp(argument, "--mode")) valid = parse_mode(value, modes);
+		else if (!std::strcmp(argument, "--report")) report_path = value;
+		else if (!std::strcmp(argument, "--max-reported")) verify.max_reported = std::strtoull(value, nullptr, 0);
+		else valid = false;
+		if (!valid)
+		{
+			fmt::cerr.format("usage: %0 [--threads <n>] [--shard <k>/<n>] [--begin <bits>] [--end <bits>] [--mode <name>]... [--report <path>] [--max-reported <n>]\n", argv[0]);
+			fmt::cerr.print("modes:");
+			for (const char * name : mode_names) fmt::cerr.format(" %0", name);
+			fmt::cerr.print('\n');
+			return 2;
+		}
+		++i;
+	}
+	if (modes) verify.modes = modes;
+	verify.end_value = std::min(verify.end_value, uint64_t(1) << 32);
+	verify.first_value = std::min(verify.first_value, verify.end_value);
+	uint64_t total = verify.end_value - verify.first_value;
+	verify.end_value = verify.first_value + total * (shard + 1) / num_shards;
+	verify.first_value += total * shard / num_shards;
+	total = verify.end_value - verify.first_value;
+
+	fmt::cerr.format("checking 0x%0 to 0x%1 on %2 threads\n", fmt::hex(verify.first_value), fmt::hex(verify.end_value), num_threads);
+	auto start = std::chrono::steady_clock::now();
+	std::atomic<bool> done{false};
+	std::thread runner([&]
+	{
+		verify.run(num_threads);
+		done = true;
+	});
+	auto seconds_since_start = [&]
+	{
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	};
+	// progress every ten seconds
+	for (int ticks = 1; !done; ++ticks)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(100));
+		if (done || ticks % 100) continue;
+		double seconds = seconds_since_start();
+		uint64_t checked = verify.checked;
+		double per_second = checked / seconds;
+		fmt::cerr.format("%0%% checked, %1 floats/s, %2 mismatches, %3s left\n", fmt::precise_float(100.0 * checked / total, 3), fmt::precise_float(per_second, 3), verify.num_mismatches.load(), fmt::precise_float((total - checked) / per_second, 3));
+	}
+	runner.join();
+	double seconds = seconds_since_start();
+
+	std::vector<mismatch> reported;
+	uint64_t mismatches[num_modes] = {};
+	for (const std::unique_ptr<worker> & worker : verify.workers)
+	{
+		reported.insert(reported.end(), worker->reported.begin(), worker->reported.end());
+		for (int i = 0; i < num_modes; ++i) mismatches[i] += worker->mismatches[i];
+	}
+	std::sort(reported.begin(), reported.end(), [](const mismatch & lhs, const mismatch & rhs)
+	{
+		return lhs.bits < rhs.bits || (lhs.bits == rhs.bits && lhs.mode < rhs.mode);
+	});
+
+	int fd = report_path ? open(report_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644) : STDOUT_FILENO;
+	if (fd < 0)
+	{
+		std::perror(report_path);
+		return 2;
+	}
+	fmt::fd_writer writer(fd);
+	auto out = fmt::make_format_it(writer.sink());
+	out.format("checked %0 floats from 0x%1 to 0x%2 in %3s, %4 floats/s\n", total, fmt::hex(verify.first_value), fmt::hex(verify.end_value), fmt::precise_float(seconds, 4), fmt::precise_float(total / seconds, 4));
+	for (int i = 0; i < num_modes; ++i)
+	{
+		if (verify.modes & (1u << i)) out.format("%0: %1 mismatches\n", mode_names[i], mismatches[i]);
+	}
+	for (const mismatch & wrong : reported)
+	{
+		float value;
+		std::memcpy(&value, &wrong.bits, sizeof(value));
+		out.format("0x%0 %1: expected \"%2\" but got \"%3\" (%4)\n", fmt::hex_fixed(wrong.bits), mode_names[wrong.mode], wrong.expected, wrong.actual, fmt::nodrift_float(value));
+	}
+	if (reported.size() < verify.num_mismatches) out.format("%0 more mismatches were not reported\n", verify.num_mismatches - reported.size());
+	writer.flush();
+	if (report_path) close(fd);
+	return verify.num_mismatches ? 1 : 0;
+}